@@ -0,0 +1,130 @@
+// Сравнение таблицы StopsDistances с прежней unordered_map по парам указателей
+// на остановки: заполнение и поиск с учётом обратного направления.
+// Запуск: stops_distances_benchmark [stops] [distances] [lookups]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../domain.h"
+#include "../stops_distances.h"
+
+using namespace transport_catalogue;
+
+namespace {
+
+// хеш прежней таблицы расстояний
+struct PairOfStopPtrHasher {
+	size_t operator() (const std::pair<domain::StopPtr, domain::StopPtr>& p) const {
+		auto ptr_h1 = ptr_hasher(p.first);
+		auto ptr_h2 = ptr_hasher(p.second);
+
+		return ptr_h1 + ptr_h2 * 43;
+	}
+	std::hash<const void*> ptr_hasher;
+};
+
+using OldStopsDistances = std::unordered_map<std::pair<domain::StopPtr, domain::StopPtr>,
+		uint64_t, PairOfStopPtrHasher>;
+
+// поиск в прежней таблице: сначала прямое направление, затем обратное
+uint64_t FindOld(const OldStopsDistances& distances, domain::StopPtr from, domain::StopPtr to) {
+	if (const auto pair = std::make_pair(from, to); distances.count(pair)) {
+		return distances.at(pair);
+	} else if (const auto pair = std::make_pair(to, from); distances.count(pair)) {
+		return distances.at(pair);
+	}
+	return 0;
+}
+
+struct Distance {
+	domain::StopId from;
+	domain::StopId to;
+	uint64_t distance;
+};
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+	const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+	const size_t distance_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+	const size_t lookup_count = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 2000000;
+	if (stop_count < 2) {
+		std::cerr << "At least two stops are required\n";
+		return 1;
+	}
+
+	std::mt19937_64 random(42);
+	std::uniform_int_distribution<domain::StopId> random_stop(0, static_cast<domain::StopId>(stop_count - 1));
+	std::uniform_int_distribution<uint64_t> random_distance(1, 100000);
+
+	domain::Stops stops;
+	for (size_t i = 0; i < stop_count; ++i) {
+		stops.push_back(domain::Stop{{}, {}, static_cast<domain::StopId>(i)});
+	}
+
+	std::vector<Distance> distances(distance_count);
+	for (auto& distance : distances) {
+		distance = {random_stop(random), random_stop(random), random_distance(random)};
+	}
+
+	// половина запросов — к заданным расстояниям в случайном направлении, половина — случайные пары
+	std::vector<std::pair<domain::StopId, domain::StopId>> lookups(lookup_count);
+	for (size_t i = 0; i < lookup_count; ++i) {
+		if (i % 2 == 0 && !distances.empty()) {
+			const auto& distance = distances[random() % distances.size()];
+			lookups[i] = random() % 2 ? std::make_pair(distance.from, distance.to) : std::make_pair(distance.to, distance.from);
+		} else {
+			lookups[i] = {random_stop(random), random_stop(random)};
+		}
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	OldStopsDistances old_distances;
+	for (const auto& distance : distances) {
+		old_distances[{&stops[distance.from], &stops[distance.to]}] = distance.distance;
+	}
+	const double old_fill = MillisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	uint64_t old_sum = 0;
+	for (const auto& [from, to] : lookups) {
+		old_sum += FindOld(old_distances, &stops[from], &stops[to]);
+	}
+	const double old_find = MillisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	StopsDistances new_distances;
+	new_distances.Reserve(distances.size());
+	for (const auto& distance : distances) {
+		new_distances.Set(distance.from, distance.to, distance.distance);
+	}
+	const double new_fill = MillisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	uint64_t new_sum = 0;
+	for (const auto& [from, to] : lookups) {
+		new_sum += new_distances.Find(from, to);
+	}
+	const double new_find = MillisecondsSince(start);
+
+	std::cout << "stops " << stop_count << ", distances " << distance_count << ", lookups " << lookup_count << '\n'
+			<< "unordered_map:  fill " << old_fill << " ms, find " << old_find << " ms\n"
+			<< "StopsDistances: fill " << new_fill << " ms, find " << new_find << " ms\n";
+
+	if (old_sum != new_sum) {
+		std::cerr << "Lookup sums differ: " << old_sum << " != " << new_sum << '\n';
+		return 1;
+	}
+	return 0;
+}
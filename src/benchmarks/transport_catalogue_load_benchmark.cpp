@@ -0,0 +1,126 @@
+// Сравнение загрузки справочника целиком (TransportCatalogue::Load) с добавлением
+// остановок, расстояний и маршрутов по одному, как в make_base до появления Load.
+// Справочник генерируется с фиксированным зерном.
+// Запуск: transport_catalogue_load_benchmark [stops] [distances] [buses]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../domain.h"
+#include "../transport_catalogue.h"
+
+using namespace transport_catalogue;
+
+namespace {
+
+const size_t MIN_ROUTE_SIZE = 5;
+const size_t MAX_ROUTE_SIZE = 30;
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// названия в data ссылаются на строки names
+CatalogueData GenerateCatalogue(size_t stop_count, size_t distance_count, size_t bus_count,
+		std::deque<std::string>& names) {
+	std::mt19937_64 random(42);
+	std::uniform_int_distribution<size_t> random_stop(0, stop_count - 1);
+	std::uniform_real_distribution<double> random_latitude(55.5, 56.);
+	std::uniform_real_distribution<double> random_longitude(37.3, 37.9);
+	std::uniform_int_distribution<uint64_t> random_distance(100, 5000);
+	std::uniform_int_distribution<size_t> random_route_size(MIN_ROUTE_SIZE, MAX_ROUTE_SIZE);
+
+	CatalogueData data;
+	data.stops.reserve(stop_count);
+	for (size_t i = 0; i < stop_count; ++i) {
+		const auto& name = names.emplace_back("Stop " + std::to_string(i));
+		data.stops.push_back(domain::Stop{name, {random_latitude(random), random_longitude(random)}});
+	}
+	data.distances.reserve(distance_count);
+	for (size_t i = 0; i < distance_count; ++i) {
+		// расстояния от одной остановки идут подряд, как во входных данных
+		const size_t from = i * stop_count / distance_count;
+		data.distances.push_back({data.stops[from].name, data.stops[random_stop(random)].name, random_distance(random)});
+	}
+	data.buses.reserve(bus_count);
+	for (size_t i = 0; i < bus_count; ++i) {
+		const auto& name = names.emplace_back("Bus " + std::to_string(i));
+		domain::BusByStopNames bus{name, random() % 2 == 0, {}};
+		const size_t route_size = random_route_size(random);
+		for (size_t j = 0; j < route_size; ++j) {
+			bus.stop_names.push_back(data.stops[random_stop(random)].name);
+		}
+		if (bus.is_circle) {
+			bus.stop_names.push_back(bus.stop_names.front());
+		}
+		data.buses.push_back(std::move(bus));
+	}
+	return data;
+}
+
+void AddIncrementally(const CatalogueData& data, TransportCatalogue& catalogue) {
+	for (const auto& stop : data.stops) {
+		catalogue.AddStop(stop);
+	}
+	catalogue.AddStopsDistances(std::deque<domain::FromToDistance>(data.distances.begin(), data.distances.end()));
+	for (const auto& bus : data.buses) {
+		domain::BusDescription description{std::string(bus.name), bus.is_circle, {}};
+		description.route.reserve(bus.stop_names.size());
+		for (const auto stop_name : bus.stop_names) {
+			description.route.push_back(catalogue.FindStop(stop_name));
+		}
+		catalogue.AddBus(std::move(description));
+	}
+	catalogue.Finalize();
+}
+
+// контрольная сумма статистики маршрутов
+uint64_t Checksum(const TransportCatalogue& catalogue) {
+	uint64_t result = 0;
+	for (const auto& bus : catalogue.GetBuses()) {
+		const auto stat = catalogue.GetRouteInfo(&bus);
+		result += stat.route_length + stat.stop_count * 7 + stat.unique_stop_count * 13;
+	}
+	return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+	const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+	const size_t distance_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 300000;
+	const size_t bus_count = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20000;
+	if (stop_count == 0) {
+		std::cerr << "At least one stop is required\n";
+		return 1;
+	}
+
+	std::deque<std::string> names;
+	const CatalogueData data = GenerateCatalogue(stop_count, distance_count, bus_count, names);
+
+	auto start = std::chrono::steady_clock::now();
+	TransportCatalogue incremental;
+	AddIncrementally(data, incremental);
+	const double incremental_time = MillisecondsSince(start);
+
+	start = std::chrono::steady_clock::now();
+	TransportCatalogue loaded;
+	loaded.Load(data);
+	const double load_time = MillisecondsSince(start);
+
+	std::cout << "stops " << stop_count << ", distances " << distance_count << ", buses " << bus_count << '\n'
+			<< "incremental: " << incremental_time << " ms\n"
+			<< "Load:        " << load_time << " ms\n";
+
+	if (Checksum(incremental) != Checksum(loaded)) {
+		std::cerr << "Bus stats differ\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,334 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Иерархия сжатия (contraction hierarchy): вершины упорядочены по рангу,
+// граф разбит на рёбра «вверх» (к вершинам большего ранга) и «вниз».
+// Вершины перенумерованы позициями: позиция 0 у вершины с наибольшим рангом,
+// поэтому проход «вниз» — это линейный проход по позициям.
+template <typename Weight>
+class ContractionHierarchy {
+private:
+	static_assert(std::is_floating_point_v<Weight>, "Weight should be a floating point type");
+	using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+	using Position = uint32_t;
+
+	struct Arc {
+		Position other;
+		Weight weight;
+	};
+
+	explicit ContractionHierarchy(const Graph& graph);
+
+	size_t GetVertexCount() const;
+
+	Position GetPosition(VertexId vertex) const;
+	VertexId GetVertex(Position position) const;
+
+	// рёбра из позиции в позиции с меньшим номером (к вершинам большего ранга)
+	ranges::Range<typename std::vector<Arc>::const_iterator> GetUpwardArcs(Position position) const;
+	// рёбра, входящие в позицию из позиций с меньшим номером
+	ranges::Range<typename std::vector<Arc>::const_iterator> GetDownwardArcs(Position position) const;
+
+	size_t GetShortcutCount() const;
+
+	memory_usage::Report MemoryUsage() const;
+
+private:
+	struct ContractionState {
+		std::vector<std::unordered_map<VertexId, Weight>> out;
+		std::vector<std::unordered_map<VertexId, Weight>> in;
+		std::vector<bool> contracted;
+		std::vector<int> contracted_neighbours;
+	};
+
+	// найденные в процессе сжатия рёбра: {from, to, weight}
+	struct RankedEdge {
+		VertexId from;
+		VertexId to;
+		Weight weight;
+	};
+
+	static constexpr size_t WITNESS_SETTLED_LIMIT = 256;
+
+	std::vector<Position> vertex_to_position_;
+	std::vector<VertexId> position_to_vertex_;
+	std::vector<size_t> upward_begin_;
+	std::vector<Arc> upward_arcs_;
+	std::vector<size_t> downward_begin_;
+	std::vector<Arc> downward_arcs_;
+	size_t shortcut_count_ = 0;
+
+	static void AddArc(std::unordered_map<VertexId, Weight>& arcs, VertexId to, Weight weight);
+
+	// ищет пути из source в обход вершины skipped, не длиннее limit
+	static std::unordered_map<VertexId, Weight> FindWitnesses(const ContractionState& state,
+			VertexId source, VertexId skipped, Weight limit);
+
+	// возвращает список ярлыков, необходимых при сжатии vertex
+	static std::vector<RankedEdge> CollectShortcuts(const ContractionState& state, VertexId vertex);
+
+	static int ComputePriority(const ContractionState& state, VertexId vertex);
+
+	void Contract(ContractionState& state, VertexId vertex,
+			std::vector<RankedEdge>& upward, std::vector<RankedEdge>& downward);
+
+	static void FillArcs(const std::vector<RankedEdge>& edges, bool by_source,
+			const std::vector<Position>& vertex_to_position,
+			std::vector<size_t>& begin, std::vector<Arc>& arcs);
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph) {
+	const size_t vertex_count = graph.GetVertexCount();
+	if (vertex_count > std::numeric_limits<Position>::max()) {
+		throw std::length_error("Graph is too large for contraction hierarchy");
+	}
+
+	ContractionState state;
+	state.out.resize(vertex_count);
+	state.in.resize(vertex_count);
+	state.contracted.assign(vertex_count, false);
+	state.contracted_neighbours.assign(vertex_count, 0);
+
+	for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+		const auto& edge = graph.GetEdge(edge_id);
+		if (edge.weight < Weight{}) {
+			throw std::domain_error("Edges' weights should be non-negative");
+		}
+		if (edge.from == edge.to) {
+			continue;
+		}
+		AddArc(state.out[edge.from], edge.to, edge.weight);
+		AddArc(state.in[edge.to], edge.from, edge.weight);
+	}
+
+	using QueueItem = std::pair<int, VertexId>;
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+	for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+		queue.push({ComputePriority(state, vertex), vertex});
+	}
+
+	std::vector<RankedEdge> upward;
+	std::vector<RankedEdge> downward;
+	std::vector<VertexId> contraction_order;
+	contraction_order.reserve(vertex_count);
+
+	while (!queue.empty()) {
+		const VertexId vertex = queue.top().second;
+		queue.pop();
+		if (state.contracted[vertex]) {
+			continue;
+		}
+		// ленивое обновление приоритета
+		const int priority = ComputePriority(state, vertex);
+		if (!queue.empty() && priority > queue.top().first) {
+			queue.push({priority, vertex});
+			continue;
+		}
+		Contract(state, vertex, upward, downward);
+		contraction_order.push_back(vertex);
+	}
+
+	// первой сжатой вершине достаётся наименьший ранг и последняя позиция
+	vertex_to_position_.resize(vertex_count);
+	position_to_vertex_.resize(vertex_count);
+	for (size_t rank = 0; rank < vertex_count; ++rank) {
+		const auto position = static_cast<Position>(vertex_count - 1 - rank);
+		vertex_to_position_[contraction_order[rank]] = position;
+		position_to_vertex_[position] = contraction_order[rank];
+	}
+
+	FillArcs(upward, true, vertex_to_position_, upward_begin_, upward_arcs_);
+	FillArcs(downward, false, vertex_to_position_, downward_begin_, downward_arcs_);
+}
+
+template <typename Weight>
+size_t ContractionHierarchy<Weight>::GetVertexCount() const {
+	return position_to_vertex_.size();
+}
+
+template <typename Weight>
+typename ContractionHierarchy<Weight>::Position
+ContractionHierarchy<Weight>::GetPosition(VertexId vertex) const {
+	return vertex_to_position_.at(vertex);
+}
+
+template <typename Weight>
+VertexId ContractionHierarchy<Weight>::GetVertex(Position position) const {
+	return position_to_vertex_.at(position);
+}
+
+template <typename Weight>
+ranges::Range<typename std::vector<typename ContractionHierarchy<Weight>::Arc>::const_iterator>
+ContractionHierarchy<Weight>::GetUpwardArcs(Position position) const {
+	return {upward_arcs_.begin() + upward_begin_[position],
+			upward_arcs_.begin() + upward_begin_[position + 1]};
+}
+
+template <typename Weight>
+ranges::Range<typename std::vector<typename ContractionHierarchy<Weight>::Arc>::const_iterator>
+ContractionHierarchy<Weight>::GetDownwardArcs(Position position) const {
+	return {downward_arcs_.begin() + downward_begin_[position],
+			downward_arcs_.begin() + downward_begin_[position + 1]};
+}
+
+template <typename Weight>
+size_t ContractionHierarchy<Weight>::GetShortcutCount() const {
+	return shortcut_count_;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::AddArc(std::unordered_map<VertexId, Weight>& arcs,
+		VertexId to, Weight weight) {
+	const auto [iter, inserted] = arcs.emplace(to, weight);
+	if (!inserted && weight < iter->second) {
+		iter->second = weight;
+	}
+}
+
+template <typename Weight>
+std::unordered_map<VertexId, Weight> ContractionHierarchy<Weight>::FindWitnesses(
+		const ContractionState& state, VertexId source, VertexId skipped, Weight limit) {
+	using QueueItem = std::pair<Weight, VertexId>;
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+	std::unordered_map<VertexId, Weight> distances;
+
+	distances[source] = Weight{};
+	queue.push({Weight{}, source});
+	size_t settled = 0;
+	while (!queue.empty() && settled < WITNESS_SETTLED_LIMIT) {
+		const auto [distance, vertex] = queue.top();
+		queue.pop();
+		if (distance > distances[vertex]) {
+			continue;
+		}
+		if (distance > limit) {
+			break;
+		}
+		++settled;
+		for (const auto& [to, weight] : state.out[vertex]) {
+			if (to == skipped || state.contracted[to]) {
+				continue;
+			}
+			const Weight candidate = distance + weight;
+			const auto iter = distances.find(to);
+			if (iter == distances.end() || candidate < iter->second) {
+				distances[to] = candidate;
+				queue.push({candidate, to});
+			}
+		}
+	}
+	return distances;
+}
+
+template <typename Weight>
+std::vector<typename ContractionHierarchy<Weight>::RankedEdge>
+ContractionHierarchy<Weight>::CollectShortcuts(const ContractionState& state, VertexId vertex) {
+	std::vector<RankedEdge> result;
+	if (state.out[vertex].empty()) {
+		return result;
+	}
+	Weight max_out = Weight{};
+	for (const auto& [to, weight] : state.out[vertex]) {
+		max_out = std::max(max_out, weight);
+	}
+
+	for (const auto& [from, in_weight] : state.in[vertex]) {
+		const auto witnesses = FindWitnesses(state, from, vertex, in_weight + max_out);
+		for (const auto& [to, out_weight] : state.out[vertex]) {
+			if (to == from) {
+				continue;
+			}
+			const Weight through = in_weight + out_weight;
+			const auto witness = witnesses.find(to);
+			if (witness == witnesses.end() || witness->second > through) {
+				result.push_back({from, to, through});
+			}
+		}
+	}
+	return result;
+}
+
+template <typename Weight>
+int ContractionHierarchy<Weight>::ComputePriority(const ContractionState& state, VertexId vertex) {
+	const int shortcuts = static_cast<int>(CollectShortcuts(state, vertex).size());
+	const int removed = static_cast<int>(state.in[vertex].size() + state.out[vertex].size());
+	return shortcuts - removed + state.contracted_neighbours[vertex];
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::Contract(ContractionState& state, VertexId vertex,
+		std::vector<RankedEdge>& upward, std::vector<RankedEdge>& downward) {
+	for (const auto& shortcut : CollectShortcuts(state, vertex)) {
+		AddArc(state.out[shortcut.from], shortcut.to, shortcut.weight);
+		AddArc(state.in[shortcut.to], shortcut.from, shortcut.weight);
+		++shortcut_count_;
+	}
+
+	// все оставшиеся соседи вершины будут сжаты позже, то есть имеют больший ранг
+	for (const auto& [to, weight] : state.out[vertex]) {
+		upward.push_back({vertex, to, weight});
+		state.in[to].erase(vertex);
+		++state.contracted_neighbours[to];
+	}
+	for (const auto& [from, weight] : state.in[vertex]) {
+		downward.push_back({from, vertex, weight});
+		state.out[from].erase(vertex);
+		++state.contracted_neighbours[from];
+	}
+	state.out[vertex].clear();
+	state.in[vertex].clear();
+	state.contracted[vertex] = true;
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::FillArcs(const std::vector<RankedEdge>& edges, bool by_source,
+		const std::vector<Position>& vertex_to_position,
+		std::vector<size_t>& begin, std::vector<Arc>& arcs) {
+	const size_t vertex_count = vertex_to_position.size();
+	begin.assign(vertex_count + 1, 0);
+	for (const auto& edge : edges) {
+		++begin[vertex_to_position[by_source ? edge.from : edge.to] + 1];
+	}
+	for (size_t position = 0; position < vertex_count; ++position) {
+		begin[position + 1] += begin[position];
+	}
+
+	arcs.resize(edges.size());
+	std::vector<size_t> filled(begin.begin(), begin.end() - 1);
+	for (const auto& edge : edges) {
+		const Position owner = vertex_to_position[by_source ? edge.from : edge.to];
+		const Position other = vertex_to_position[by_source ? edge.to : edge.from];
+		arcs[filled[owner]++] = Arc{other, edge.weight};
+	}
+}
+
+template <typename Weight>
+memory_usage::Report ContractionHierarchy<Weight>::MemoryUsage() const {
+	memory_usage::Report report;
+	report.Add(memory_usage::OfVector("vertex_to_position", vertex_to_position_));
+	report.Add(memory_usage::OfVector("position_to_vertex", position_to_vertex_));
+	report.Add(memory_usage::OfVector("upward_begin", upward_begin_));
+	report.Add(memory_usage::OfVector("upward_arcs", upward_arcs_));
+	report.Add(memory_usage::OfVector("downward_begin", downward_begin_));
+	report.Add(memory_usage::OfVector("downward_arcs", downward_arcs_));
+	return report;
+}
+
+}  // namespace graph
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <deque>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #include "geo.h"
 
@@ -14,15 +19,204 @@ struct Bus;
 using StopPtr = const Stop*;
 using BusPtr = const Bus*;
 
+// Плотные номера остановок и маршрутов в порядке добавления в справочник
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+using Stops = std::deque<Stop>;
+// остановки всех маршрутов, записанные подряд
+using RouteArena = std::vector<StopId>;
+
+// названия остановок и маршрутов хранятся в NameArena справочника
 struct Stop {
-	std::string name;
+	std::string_view name;
 	geo::Coordinates coordinates;
+	StopId id = 0;
+};
+
+// Представление остановок маршрута, хранящихся в общем RouteArena справочника
+class RouteView {
+public:
+	class Iterator {
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = StopPtr;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const StopPtr*;
+		using reference = StopPtr;
+
+		Iterator() = default;
+		Iterator(const StopId* stop_id, const Stops* stops)
+			: stop_id_(stop_id)
+			, stops_(stops) {
+		}
+
+		StopPtr operator*() const {
+			return &(*stops_)[*stop_id_];
+		}
+		StopPtr operator[](difference_type n) const {
+			return *(*this + n);
+		}
+
+		Iterator& operator++() {
+			++stop_id_;
+			return *this;
+		}
+		Iterator operator++(int) {
+			Iterator result = *this;
+			++stop_id_;
+			return result;
+		}
+		Iterator& operator--() {
+			--stop_id_;
+			return *this;
+		}
+		Iterator operator--(int) {
+			Iterator result = *this;
+			--stop_id_;
+			return result;
+		}
+		Iterator& operator+=(difference_type n) {
+			stop_id_ += n;
+			return *this;
+		}
+		Iterator& operator-=(difference_type n) {
+			stop_id_ -= n;
+			return *this;
+		}
+		Iterator operator+(difference_type n) const {
+			return Iterator{stop_id_ + n, stops_};
+		}
+		Iterator operator-(difference_type n) const {
+			return Iterator{stop_id_ - n, stops_};
+		}
+		difference_type operator-(const Iterator& rhs) const {
+			return stop_id_ - rhs.stop_id_;
+		}
+
+		bool operator==(const Iterator& rhs) const {
+			return stop_id_ == rhs.stop_id_;
+		}
+		bool operator!=(const Iterator& rhs) const {
+			return stop_id_ != rhs.stop_id_;
+		}
+		bool operator<(const Iterator& rhs) const {
+			return stop_id_ < rhs.stop_id_;
+		}
+
+	private:
+		const StopId* stop_id_ = nullptr;
+		const Stops* stops_ = nullptr;
+	};
+
+	using ReverseIterator = std::reverse_iterator<Iterator>;
+
+	RouteView() = default;
+	RouteView(const RouteArena* arena, const Stops* stops, uint32_t offset, uint32_t length)
+		: arena_(arena)
+		, stops_(stops)
+		, offset_(offset)
+		, length_(length) {
+	}
+
+	Iterator begin() const {
+		return Iterator{GetStopIds(), stops_};
+	}
+	Iterator end() const {
+		return Iterator{GetStopIds() + length_, stops_};
+	}
+	ReverseIterator rbegin() const {
+		return ReverseIterator{end()};
+	}
+	ReverseIterator rend() const {
+		return ReverseIterator{begin()};
+	}
+
+	size_t size() const {
+		return length_;
+	}
+	bool empty() const {
+		return length_ == 0;
+	}
+	StopPtr operator[](size_t index) const {
+		return &(*stops_)[GetStopIds()[index]];
+	}
+	StopPtr front() const {
+		return (*this)[0];
+	}
+	StopPtr back() const {
+		return (*this)[length_ - 1];
+	}
+
+	// номера остановок маршрута подряд, size() штук
+	const StopId* GetStopIds() const {
+		return arena_ ? arena_->data() + offset_ : nullptr;
+	}
+
+private:
+	const RouteArena* arena_ = nullptr;
+	const Stops* stops_ = nullptr;
+	uint32_t offset_ = 0;
+	uint32_t length_ = 0;
 };
 
 struct Bus {
-	std::string name;
+	std::string_view name;
 	bool is_circle;
-	std::deque<StopPtr> route;
+	RouteView route;
+	BusId id = 0;
+};
+
+// Накопленные расстояния вдоль полного пути автобуса, хранящиеся в массивах справочника.
+// Позиции нумеруют остановки пути: у некольцевого маршрута за конечной идут
+// остановки обратного направления. Длина участка между позициями from <= to —
+// одно вычитание
+class RouteDistances {
+public:
+	RouteDistances() = default;
+	RouteDistances(const std::vector<uint64_t>* road, const std::vector<double>* geo,
+			uint32_t offset, uint32_t length)
+		: road_(road)
+		, geo_(geo)
+		, offset_(offset)
+		, length_(length) {
+	}
+
+	size_t size() const {
+		return length_;
+	}
+	bool empty() const {
+		return length_ == 0;
+	}
+
+	// дорожное расстояние, м
+	uint64_t GetRoadDistance(size_t from, size_t to) const {
+		return (*road_)[offset_ + to] - (*road_)[offset_ + from];
+	}
+	// расстояние по прямой между соседними остановками, просуммированное по участку, м
+	double GetGeoDistance(size_t from, size_t to) const {
+		return (*geo_)[offset_ + to] - (*geo_)[offset_ + from];
+	}
+
+private:
+	const std::vector<uint64_t>* road_ = nullptr;
+	const std::vector<double>* geo_ = nullptr;
+	uint32_t offset_ = 0;
+	uint32_t length_ = 0;
+};
+
+// Описание маршрута для добавления в справочник
+struct BusDescription {
+	std::string name;
+	bool is_circle = false;
+	std::vector<StopPtr> route;
+};
+
+// Описание маршрута по названиям остановок, для загрузки справочника целиком
+struct BusByStopNames {
+	std::string_view name;
+	bool is_circle = false;
+	std::vector<std::string_view> stop_names;
 };
 
 struct BusStat {
@@ -38,14 +232,4 @@ struct FromToDistance {
 	uint64_t distance;
 };
 
-struct PairOfStopPtrHasher {
-	size_t operator() (const std::pair<StopPtr, StopPtr>& p) const {
-		auto ptr_h1 = ptr_hasher(p.first);
-		auto ptr_h2 = ptr_hasher(p.second);
-
-		return ptr_h1 + ptr_h2 * 43;
-	}
-	std::hash<const void*> ptr_hasher;
-};
-
 }  // transport_catalogue::domain
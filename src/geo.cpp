@@ -2,16 +2,181 @@
 #include <iostream>
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
+// AVX2-ядро собирается атрибутом target, а выбирается по процессору во время работы
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GEO_HAS_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
 namespace geo {
 
+namespace {
+
+const double DR = M_PI / 180.;
+
+// расстояние по поверхности по длине хорды единичной сферы
+double ChordToDistance(double chord) {
+	return 2. * EARTH_RADIUS * std::asin(std::min(1., chord / 2.));
+}
+
+double ComputeChord(const UnitVector& from, const UnitVector& to) {
+	const double dx = from.x - to.x;
+	const double dy = from.y - to.y;
+	const double dz = from.z - to.z;
+	return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+}  // namespace
+
 double ComputeDistance(Coordinates from, Coordinates to) {
 	using namespace std;
-	const double dr = M_PI / 180.0;
-	return acos(sin(from.lat * dr) * sin(to.lat * dr)
-				+ cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-		* 6371000;
+	// для совпадающих точек погрешность может вывести косинус за 1
+	const double cos_angle = sin(from.lat * DR) * sin(to.lat * DR)
+			+ cos(from.lat * DR) * cos(to.lat * DR) * cos(abs(from.lng - to.lng) * DR);
+	return acos(std::clamp(cos_angle, -1., 1.)) * EARTH_RADIUS;
+}
+
+double ComputeHaversineDistance(Coordinates from, Coordinates to) {
+	using namespace std;
+	const double sin_dlat = sin((to.lat - from.lat) * DR / 2.);
+	const double sin_dlng = sin((to.lng - from.lng) * DR / 2.);
+	const double a = sin_dlat * sin_dlat
+			+ cos(from.lat * DR) * cos(to.lat * DR) * sin_dlng * sin_dlng;
+	return 2. * EARTH_RADIUS * asin(min(1., sqrt(a)));
+}
+
+UnitVector ToUnitVector(Coordinates point) {
+	const double cos_lat = std::cos(point.lat * DR);
+	return {cos_lat * std::cos(point.lng * DR), cos_lat * std::sin(point.lng * DR), std::sin(point.lat * DR)};
+}
+
+double ComputeDistance(const UnitVector& from, const UnitVector& to) {
+	return ChordToDistance(ComputeChord(from, to));
+}
+
+namespace {
+
+void ComputeDistancesScalar(UnitVectorsView from, UnitVectorsView to, size_t count, double* distances) {
+	for (size_t i = 0; i < count; ++i) {
+		distances[i] = ComputeDistance(UnitVector{from.x[i], from.y[i], from.z[i]},
+				UnitVector{to.x[i], to.y[i], to.z[i]});
+	}
+}
+
+#ifdef GEO_HAS_AVX2_KERNEL
+// Рациональные приближения арксинуса из библиотеки Cephes, точность до 1 ulp:
+// asin(x) = x + x * x² * P(x²) / Q(x²) при x <= 0.625,
+// asin(x) = pi/2 - 2 * asin(sqrt((1 - x) / 2)) через R(1 - x) / S(1 - x) при x > 0.625.
+// У Q и S старший коэффициент 1 и здесь опущен
+const double ASIN_P[] = {4.253011369004428248960e-3, -6.019598008014123785661e-1, 5.444622390564711410273e0,
+		-1.626247967210700244449e1, 1.956261983317594739197e1, -8.198089802484824371615e0};
+const double ASIN_Q[] = {-1.474091372988853791896e1, 7.049610280856842141659e1, -1.471791292232726029859e2,
+		1.395105614657485689735e2, -4.918853881490881290097e1};
+const double ASIN_R[] = {2.967721961301243206100e-3, -5.634242780008963776856e-1, 6.968710824104713396794e0,
+		-2.556901049652824852289e1, 2.853665548261061424989e1};
+const double ASIN_S[] = {-2.194779531642920639778e1, 1.470656354026814941758e2, -3.838770957603691357202e2,
+		3.424398657913078477438e2};
+const double ASIN_PIO4 = 7.85398163397448309616e-1;
+const double ASIN_MOREBITS = 6.123233995736765886130e-17; // остаток pi/2 за пределами double
+
+// многочлен со старшим коэффициентом coefficients[0] по схеме Горнера
+template <size_t N>
+__attribute__((target("avx2")))
+__m256d EvaluatePolynomial(__m256d x, const double (&coefficients)[N]) {
+	__m256d result = _mm256_set1_pd(coefficients[0]);
+	for (size_t i = 1; i < N; ++i) {
+		result = _mm256_add_pd(_mm256_mul_pd(result, x), _mm256_set1_pd(coefficients[i]));
+	}
+	return result;
+}
+
+// то же с опущенным старшим коэффициентом 1
+template <size_t N>
+__attribute__((target("avx2")))
+__m256d EvaluateMonicPolynomial(__m256d x, const double (&coefficients)[N]) {
+	__m256d result = _mm256_add_pd(x, _mm256_set1_pd(coefficients[0]));
+	for (size_t i = 1; i < N; ++i) {
+		result = _mm256_add_pd(_mm256_mul_pd(result, x), _mm256_set1_pd(coefficients[i]));
+	}
+	return result;
+}
+
+// asin для 0 <= x <= 1. Считаются обе ветви, нужная выбирается маской
+__attribute__((target("avx2")))
+__m256d ComputeAsinAvx2(__m256d x) {
+	const __m256d squared = _mm256_mul_pd(x, x);
+	const __m256d small = _mm256_add_pd(x, _mm256_mul_pd(x, _mm256_div_pd(
+			_mm256_mul_pd(squared, EvaluatePolynomial(squared, ASIN_P)),
+			EvaluateMonicPolynomial(squared, ASIN_Q))));
+
+	const __m256d complement = _mm256_sub_pd(_mm256_set1_pd(1.), x);
+	const __m256d ratio = _mm256_div_pd(
+			_mm256_mul_pd(complement, EvaluatePolynomial(complement, ASIN_R)),
+			EvaluateMonicPolynomial(complement, ASIN_S));
+	const __m256d root = _mm256_sqrt_pd(_mm256_add_pd(complement, complement));
+	const __m256d pio4 = _mm256_set1_pd(ASIN_PIO4);
+	const __m256d correction = _mm256_sub_pd(_mm256_mul_pd(root, ratio), _mm256_set1_pd(ASIN_MOREBITS));
+	const __m256d large = _mm256_add_pd(_mm256_sub_pd(_mm256_sub_pd(pio4, root), correction), pio4);
+
+	return _mm256_blendv_pd(small, large, _mm256_cmp_pd(x, _mm256_set1_pd(0.625), _CMP_GT_OQ));
+}
+
+__attribute__((target("avx2")))
+void ComputeDistancesAvx2(UnitVectorsView from, UnitVectorsView to, size_t count, double* distances) {
+	const __m256d half = _mm256_set1_pd(0.5);
+	const __m256d one = _mm256_set1_pd(1.);
+	const __m256d diameter = _mm256_set1_pd(2. * EARTH_RADIUS);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(from.x + i), _mm256_loadu_pd(to.x + i));
+		const __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(from.y + i), _mm256_loadu_pd(to.y + i));
+		const __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(from.z + i), _mm256_loadu_pd(to.z + i));
+		__m256d squared = _mm256_mul_pd(dx, dx);
+		squared = _mm256_add_pd(squared, _mm256_mul_pd(dy, dy));
+		squared = _mm256_add_pd(squared, _mm256_mul_pd(dz, dz));
+		// как в ChordToDistance: 2R * asin(min(1, chord / 2))
+		const __m256d half_chord = _mm256_min_pd(one, _mm256_mul_pd(_mm256_sqrt_pd(squared), half));
+		_mm256_storeu_pd(distances + i, _mm256_mul_pd(diameter, ComputeAsinAvx2(half_chord)));
+	}
+	ComputeDistancesScalar(from.Advanced(i), to.Advanced(i), count - i, distances + i);
+}
+#endif
+
+}  // namespace
+
+bool IsSupported(DistanceKernel kernel) {
+	switch (kernel) {
+		case DistanceKernel::AUTO:
+		case DistanceKernel::SCALAR:
+			return true;
+		case DistanceKernel::AVX2:
+#ifdef GEO_HAS_AVX2_KERNEL
+		{
+			static const bool has_avx2 = __builtin_cpu_supports("avx2");
+			return has_avx2;
+		}
+#else
+			return false;
+#endif
+	}
+	return false;
+}
+
+void ComputeDistances(UnitVectorsView from, UnitVectorsView to, size_t count, double* distances,
+		DistanceKernel kernel) {
+	if (kernel == DistanceKernel::AUTO) {
+		kernel = IsSupported(DistanceKernel::AVX2) ? DistanceKernel::AVX2 : DistanceKernel::SCALAR;
+	}
+#ifdef GEO_HAS_AVX2_KERNEL
+	if (kernel == DistanceKernel::AVX2 && IsSupported(kernel)) {
+		ComputeDistancesAvx2(from, to, count, distances);
+		return;
+	}
+#endif
+	ComputeDistancesScalar(from, to, count, distances);
 }
 
 }  // namespace geo
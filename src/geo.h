@@ -1,12 +1,83 @@
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 namespace geo {
 
+inline constexpr double EARTH_RADIUS = 6371000.; // м
+
 struct Coordinates {
 	double lat; // Широта
 	double lng; // Долгота
 };
 
+// Точка на единичной сфере. Считается один раз на остановку, после чего
+// расстояния находятся без тригонометрии от координат
+struct UnitVector {
+	double x = 0.;
+	double y = 0.;
+	double z = 0.;
+};
+
 double ComputeDistance(Coordinates from, Coordinates to);
 
+// Формула гаверсинусов: точнее ComputeDistance на малых расстояниях
+double ComputeHaversineDistance(Coordinates from, Coordinates to);
+
+UnitVector ToUnitVector(Coordinates point);
+
+double ComputeDistance(const UnitVector& from, const UnitVector& to);
+
+// Точки на единичной сфере, координаты которых лежат в трёх отдельных массивах.
+// Векторное ядро загружает по четыре координаты одной инструкцией
+struct UnitVectorsView {
+	const double* x = nullptr;
+	const double* y = nullptr;
+	const double* z = nullptr;
+
+	// те же массивы, начиная с точки offset
+	UnitVectorsView Advanced(size_t offset) const {
+		return {x + offset, y + offset, z + offset};
+	}
+};
+
+// Владеющий вариант UnitVectorsView
+struct UnitVectors {
+	std::vector<double> x;
+	std::vector<double> y;
+	std::vector<double> z;
+
+	UnitVectors() = default;
+	explicit UnitVectors(size_t size)
+		: x(size), y(size), z(size) {
+	}
+
+	void Set(size_t index, const UnitVector& point) {
+		x[index] = point.x;
+		y[index] = point.y;
+		z[index] = point.z;
+	}
+
+	UnitVectorsView View() const {
+		return {x.data(), y.data(), z.data()};
+	}
+};
+
+// Способ вычисления расстояний в ComputeDistances
+enum class DistanceKernel {
+	AUTO, // AVX2, если его поддерживает процессор, иначе SCALAR
+	SCALAR,
+	AVX2, // по четыре расстояния за раз, вместе с арксинусом
+};
+
+// поддерживает ли kernel процессор, на котором запущена программа
+bool IsSupported(DistanceKernel kernel);
+
+// distances[i] = расстояние от from[i] до to[i], i < count.
+// Расстояние считается через длину хорды, что равносильно формуле гаверсинусов.
+// Неподдерживаемый kernel заменяется на SCALAR
+void ComputeDistances(UnitVectorsView from, UnitVectorsView to, size_t count, double* distances,
+		DistanceKernel kernel = DistanceKernel::AUTO);
+
 }  // namespace geo
@@ -0,0 +1,210 @@
+#define _USE_MATH_DEFINES
+#include "geo_grid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+
+namespace geo {
+
+namespace {
+
+const double DR = M_PI / 180.;
+
+}  // namespace
+
+Grid::Grid(const std::vector<Coordinates>& points, double min_cell_size) {
+	if (points.empty()) {
+		return;
+	}
+	Coordinates max = points.front();
+	layout_.min = points.front();
+	for (const auto& point : points) {
+		layout_.min.lat = std::min(layout_.min.lat, point.lat);
+		layout_.min.lng = std::min(layout_.min.lng, point.lng);
+		max.lat = std::max(max.lat, point.lat);
+		max.lng = std::max(max.lng, point.lng);
+	}
+
+	// ячейки примерно квадратные в метрах
+	const double max_abs_lat = std::max(std::abs(layout_.min.lat), std::abs(max.lat));
+	const double lng_ratio = std::max(std::cos(max_abs_lat * DR), 1e-6);
+	const double height = std::max(max.lat - layout_.min.lat, 1e-9);
+	const double width = std::max((max.lng - layout_.min.lng) * lng_ratio, 1e-9);
+	const double cell_count = std::max(1., points.size() / POINTS_PER_CELL);
+	const double cell_side = std::max(std::sqrt(height * width / cell_count),
+			min_cell_size / (EARTH_RADIUS * DR * BOUND_SAFETY));
+
+	// округление вниз делает ячейки не меньше cell_side
+	layout_.rows = static_cast<uint32_t>(std::clamp(std::floor(height / cell_side), 1., cell_count));
+	layout_.cols = static_cast<uint32_t>(std::clamp(std::floor(width / cell_side), 1., cell_count));
+	// крайние точки должны попасть в сетку и после округлений
+	layout_.cell_lat = height * (1. + 1e-9) / layout_.rows;
+	layout_.cell_lng = std::max(max.lng - layout_.min.lng, 1e-9) * (1. + 1e-9) / layout_.cols;
+
+	const size_t cells = static_cast<size_t>(layout_.rows) * layout_.cols;
+	layout_.cell_begin.assign(cells + 1, 0);
+	std::vector<uint32_t> point_cells(points.size());
+	for (size_t i = 0; i < points.size(); ++i) {
+		point_cells[i] = static_cast<uint32_t>(GetRow(points[i].lat) * layout_.cols + GetCol(points[i].lng));
+		++layout_.cell_begin[point_cells[i] + 1];
+	}
+	for (size_t cell = 0; cell < cells; ++cell) {
+		layout_.cell_begin[cell + 1] += layout_.cell_begin[cell];
+	}
+	layout_.ids.resize(points.size());
+	std::vector<uint32_t> filled(layout_.cell_begin.begin(), layout_.cell_begin.end() - 1);
+	for (size_t i = 0; i < points.size(); ++i) {
+		layout_.ids[filled[point_cells[i]]++] = static_cast<uint32_t>(i);
+	}
+
+	FillCellPoints(points);
+}
+
+Grid::Grid(Layout layout, const std::vector<Coordinates>& points)
+	: layout_(std::move(layout)) {
+	if (layout_.cell_begin.size() != static_cast<size_t>(layout_.rows) * layout_.cols + 1
+			|| layout_.ids.size() != points.size()) {
+		throw std::invalid_argument("Grid layout does not match points");
+	}
+	FillCellPoints(points);
+}
+
+const Grid::Layout& Grid::GetLayout() const {
+	return layout_;
+}
+
+void Grid::FillCellPoints(const std::vector<Coordinates>& points) {
+	cell_points_.clear();
+	cell_points_.reserve(layout_.ids.size());
+	max_abs_lat_ = 0.;
+	for (const auto id : layout_.ids) {
+		cell_points_.push_back(points.at(id));
+		max_abs_lat_ = std::max(max_abs_lat_, std::abs(points[id].lat));
+	}
+}
+
+double Grid::GetMinCellMeters(Coordinates point) const {
+	const double max_abs_lat = std::min(90., std::max(max_abs_lat_, std::abs(point.lat)));
+	return EARTH_RADIUS * DR * std::min(layout_.cell_lat, layout_.cell_lng * std::cos(max_abs_lat * DR));
+}
+
+int64_t Grid::GetRow(double lat) const {
+	return static_cast<int64_t>(std::floor((lat - layout_.min.lat) / layout_.cell_lat));
+}
+
+int64_t Grid::GetCol(double lng) const {
+	return static_cast<int64_t>(std::floor((lng - layout_.min.lng) / layout_.cell_lng));
+}
+
+std::vector<Grid::Neighbour> Grid::FindNearest(Coordinates point, size_t count) const {
+	std::vector<Neighbour> result;
+	if (!count || layout_.ids.empty()) {
+		return result;
+	}
+
+	const auto further = [](const Neighbour& lhs, const Neighbour& rhs) {
+		return lhs.distance < rhs.distance || (lhs.distance == rhs.distance && lhs.id < rhs.id);
+	};
+	// наверху — самый дальний из найденных
+	std::priority_queue<Neighbour, std::vector<Neighbour>, decltype(further)> found(further);
+
+	const int64_t rows = layout_.rows;
+	const int64_t cols = layout_.cols;
+	// точка запроса может лежать вне сетки
+	const int64_t row = GetRow(point.lat);
+	const int64_t col = GetCol(point.lng);
+	const int64_t max_ring = std::max({row, rows - 1 - row, col, cols - 1 - col});
+	const double min_cell_meters = GetMinCellMeters(point) * BOUND_SAFETY;
+
+	const auto visit_cell = [&](int64_t cell_row, int64_t cell_col) {
+		const size_t cell = cell_row * cols + cell_col;
+		for (uint32_t pos = layout_.cell_begin[cell]; pos < layout_.cell_begin[cell + 1]; ++pos) {
+			const Neighbour candidate{layout_.ids[pos], ComputeHaversineDistance(point, cell_points_[pos])};
+			if (found.size() < count) {
+				found.push(candidate);
+			} else if (further(candidate, found.top())) {
+				found.pop();
+				found.push(candidate);
+			}
+		}
+	};
+
+	// кольца ближе first_ring не задевают сетку
+	const int64_t first_ring = std::max({int64_t{0}, -row, row - (rows - 1), -col, col - (cols - 1)});
+	for (int64_t ring = first_ring; ring <= max_ring; ++ring) {
+		// ячейки кольца ring отделены от ячейки запроса хотя бы ring - 1 ячейками
+		if (found.size() == count && ring > 0
+				&& (ring - 1) * min_cell_meters > found.top().distance) {
+			break;
+		}
+		// обходится только часть кольца внутри сетки
+		const int64_t first_col = std::max(int64_t{0}, col - ring);
+		const int64_t last_col = std::min(cols - 1, col + ring);
+		for (const int64_t cell_row : {row - ring, row + ring}) {
+			if (cell_row >= 0 && cell_row < rows) {
+				for (int64_t cell_col = first_col; cell_col <= last_col; ++cell_col) {
+					visit_cell(cell_row, cell_col);
+				}
+			}
+			if (ring == 0) {
+				break;
+			}
+		}
+		const int64_t first_row = std::max(int64_t{0}, row - ring + 1);
+		const int64_t last_row = std::min(rows - 1, row + ring - 1);
+		for (const int64_t cell_col : {col - ring, col + ring}) {
+			if (ring == 0 || cell_col < 0 || cell_col >= cols) {
+				continue;
+			}
+			for (int64_t cell_row = first_row; cell_row <= last_row; ++cell_row) {
+				visit_cell(cell_row, cell_col);
+			}
+		}
+	}
+
+	result.resize(found.size());
+	for (size_t i = result.size(); i > 0; --i) {
+		result[i - 1] = found.top();
+		found.pop();
+	}
+	return result;
+}
+
+std::vector<uint32_t> Grid::FindInBox(Coordinates min, Coordinates max) const {
+	std::vector<uint32_t> result;
+	if (layout_.ids.empty() || min.lat > max.lat || min.lng > max.lng) {
+		return result;
+	}
+	const int64_t first_row = std::max<int64_t>(0, GetRow(min.lat));
+	const int64_t last_row = std::min<int64_t>(layout_.rows - 1, GetRow(max.lat));
+	const int64_t first_col = std::max<int64_t>(0, GetCol(min.lng));
+	const int64_t last_col = std::min<int64_t>(layout_.cols - 1, GetCol(max.lng));
+	if (first_col > last_col) {
+		return result;
+	}
+	// ячейки одной строки сетки идут в ids подряд
+	for (int64_t row = first_row; row <= last_row; ++row) {
+		const size_t first_cell = row * layout_.cols + first_col;
+		const size_t last_cell = row * layout_.cols + last_col;
+		for (uint32_t pos = layout_.cell_begin[first_cell]; pos < layout_.cell_begin[last_cell + 1]; ++pos) {
+			const auto& point = cell_points_[pos];
+			if (point.lat >= min.lat && point.lat <= max.lat && point.lng >= min.lng && point.lng <= max.lng) {
+				result.push_back(layout_.ids[pos]);
+			}
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+memory_usage::Report Grid::MemoryUsage() const {
+	memory_usage::Report report;
+	report.Add(memory_usage::OfVector("cell_begin", layout_.cell_begin));
+	report.Add(memory_usage::OfVector("ids", layout_.ids));
+	report.Add(memory_usage::OfVector("cell_points", cell_points_));
+	return report;
+}
+
+}  // namespace geo
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "geo.h"
+#include "memory_usage.h"
+
+namespace geo {
+
+// Равномерная сетка в градусах над набором точек на сфере. Позволяет находить
+// ближайшие точки, точки в прямоугольнике и близкие пары точек, просматривая
+// только соседние ячейки. Раскладка сетки хранится отдельно от координат,
+// чтобы её можно было сохранить в базу и восстановить без перестроения.
+// Рассчитана на точки в пределах одного города или региона.
+class Grid {
+public:
+	struct Layout {
+		Coordinates min{0., 0.}; // нижний левый угол сетки
+		double cell_lat = 0.; // размер ячейки в градусах
+		double cell_lng = 0.;
+		uint32_t rows = 0;
+		uint32_t cols = 0;
+		std::vector<uint32_t> cell_begin; // rows * cols + 1 границ в ids
+		std::vector<uint32_t> ids; // номера точек, упорядоченные по ячейкам
+	};
+
+	struct Neighbour {
+		uint32_t id;
+		double distance; // в метрах
+	};
+
+	Grid() = default;
+	// строит сетку, в среднем не больше POINTS_PER_CELL точек на ячейку;
+	// min_cell_size — наименьший размер ячейки в метрах
+	explicit Grid(const std::vector<Coordinates>& points, double min_cell_size = 0.);
+	// восстанавливает сохранённую сетку; points — те же точки, по которым она строилась
+	Grid(Layout layout, const std::vector<Coordinates>& points);
+
+	const Layout& GetLayout() const;
+
+	// не больше count ближайших к point точек, по возрастанию расстояния
+	std::vector<Neighbour> FindNearest(Coordinates point, size_t count) const;
+
+	// точки с min.lat <= lat <= max.lat и min.lng <= lng <= max.lng, по возрастанию номера
+	std::vector<uint32_t> FindInBox(Coordinates min, Coordinates max) const;
+
+	// Вызывает callback(i, j, distance) для каждой пары точек i < j,
+	// расстояние между которыми не больше radius. Быстрее всего, когда radius
+	// не больше min_cell_size, с которым строилась сетка
+	template <typename Callback>
+	void ForEachPairWithin(double radius, Callback callback) const;
+
+	memory_usage::Report MemoryUsage() const;
+
+private:
+	static constexpr double POINTS_PER_CELL = 4.;
+	// запас на отличие расстояния по сфере от плоской оценки
+	static constexpr double BOUND_SAFETY = 0.99;
+
+	Layout layout_;
+	std::vector<Coordinates> cell_points_; // координаты точек в порядке layout_.ids
+	double max_abs_lat_ = 0.; // наибольшая по модулю широта точек
+
+	void FillCellPoints(const std::vector<Coordinates>& points);
+	// нижняя оценка размера ячейки в метрах рядом с точками и точкой запроса
+	double GetMinCellMeters(Coordinates point) const;
+	int64_t GetRow(double lat) const;
+	int64_t GetCol(double lng) const;
+};
+
+template <typename Callback>
+void Grid::ForEachPairWithin(double radius, Callback callback) const {
+	if (layout_.ids.empty() || radius < 0.) {
+		return;
+	}
+	const int64_t rows = layout_.rows;
+	const int64_t cols = layout_.cols;
+	// пары, удалённые на radius, разделены не больше чем reach - 1 ячейками
+	const double min_cell_meters = GetMinCellMeters({0., 0.}) * BOUND_SAFETY;
+	const int64_t reach = static_cast<int64_t>(std::clamp(std::ceil(radius / min_cell_meters),
+			1., static_cast<double>(std::max(rows, cols))));
+
+	for (int64_t row = 0; row < rows; ++row) {
+		for (int64_t col = 0; col < cols; ++col) {
+			const size_t cell = row * cols + col;
+			for (uint32_t lhs = layout_.cell_begin[cell]; lhs < layout_.cell_begin[cell + 1]; ++lhs) {
+				for (int64_t other_row = std::max(int64_t{0}, row - reach);
+						other_row <= std::min(rows - 1, row + reach); ++other_row) {
+					const size_t first_cell = other_row * cols + std::max(int64_t{0}, col - reach);
+					const size_t last_cell = other_row * cols + std::min(cols - 1, col + reach);
+					// ячейки одной строки сетки идут в ids подряд
+					for (uint32_t rhs = layout_.cell_begin[first_cell]; rhs < layout_.cell_begin[last_cell + 1]; ++rhs) {
+						if (layout_.ids[rhs] <= layout_.ids[lhs]) {
+							continue;
+						}
+						const double distance = ComputeDistance(cell_points_[lhs], cell_points_[rhs]);
+						if (distance <= radius) {
+							callback(size_t{layout_.ids[lhs]}, size_t{layout_.ids[rhs]}, distance);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+}  // namespace geo
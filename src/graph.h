@@ -1,8 +1,11 @@
 #pragma once
 
+#include "memory_usage.h"
 #include "ranges.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
 #include <vector>
 
 namespace graph {
@@ -10,6 +13,38 @@ namespace graph {
 using VertexId = size_t;
 using EdgeId = size_t;
 
+// Ширина номеров рёбер, хранящихся в таблице маршрутов. Номера всего графа
+// остаются size_t: ширина важна только в таблице из V^2 записей
+enum class IndexWidth : uint32_t {
+	U16 = 16,
+	U32 = 32,
+	U64 = 64,
+};
+
+// наименьшая ширина, в которой помещаются номера edge_count рёбер
+inline IndexWidth ChooseIndexWidth(size_t edge_count) {
+	if (edge_count <= std::numeric_limits<uint16_t>::max()) {
+		return IndexWidth::U16;
+	}
+	if (edge_count <= std::numeric_limits<uint32_t>::max()) {
+		return IndexWidth::U32;
+	}
+	return IndexWidth::U64;
+}
+
+// вызывает func(Index{}) с беззнаковым типом Index ширины width
+template <typename Func>
+decltype(auto) DispatchIndexWidth(IndexWidth width, Func&& func) {
+	switch (width) {
+	case IndexWidth::U16:
+		return func(uint16_t{});
+	case IndexWidth::U32:
+		return func(uint32_t{});
+	default:
+		return func(uint64_t{});
+	}
+}
+
 template <typename Weight>
 struct Edge {
 	VertexId from;
@@ -32,15 +67,21 @@ public:
 	size_t GetEdgeCount() const;
 	const Edge<Weight>& GetEdge(EdgeId edge_id) const;
 	IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+	// рёбра, входящие в vertex, для поиска в обратном направлении
+	IncidentEdgesRange GetIncomingEdges(VertexId vertex) const;
+
+	memory_usage::Report MemoryUsage() const;
 
 private:
 	std::vector<Edge<Weight>> edges_;
 	std::vector<IncidenceList> incidence_lists_;
+	std::vector<IncidenceList> reverse_incidence_lists_;
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-	: incidence_lists_(vertex_count) {
+	: incidence_lists_(vertex_count)
+	, reverse_incidence_lists_(vertex_count) {
 }
 
 template <typename Weight>
@@ -48,6 +89,7 @@ EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
 	edges_.push_back(edge);
 	const EdgeId id = edges_.size() - 1;
 	incidence_lists_.at(edge.from).push_back(id);
+	reverse_incidence_lists_.at(edge.to).push_back(id);
 	return id;
 }
 
@@ -71,4 +113,19 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
 DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
 	return ranges::AsRange(incidence_lists_.at(vertex));
 }
+
+template <typename Weight>
+typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
+DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+	return ranges::AsRange(reverse_incidence_lists_.at(vertex));
+}
+template <typename Weight>
+memory_usage::Report DirectedWeightedGraph<Weight>::MemoryUsage() const {
+	memory_usage::Report report;
+	report.Add(memory_usage::OfVector("edges", edges_));
+	report.Add(memory_usage::OfNestedVector("incidence_lists", incidence_lists_));
+	report.Add(memory_usage::OfNestedVector("reverse_incidence_lists", reverse_incidence_lists_));
+	return report;
+}
+
 }  // namespace graph
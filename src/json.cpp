@@ -1,49 +1,117 @@
 #include "json.h"
 
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <cstdio>
+#include <fstream>
 #include <iterator>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define JSON_HAS_MMAP 1
+#endif
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+// Разбор JSON указателями по непрерывному буферу. Строки без escape-последовательностей
+// передаются обработчику как ссылки на буфер
+class Parser {
+public:
+    Parser(std::string_view data, Handler& handler)
+        : pos_(data.data())
+        , end_(data.data() + data.size())
+        , handler_(handler) {
+    }
+
+    void ParseNode();
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
+private:
+    const char* pos_;
+    const char* end_;
+    Handler& handler_;
+    std::string unescaped_; // последняя строка с escape-последовательностями
+
+    int Peek() const {
+        return pos_ != end_ ? static_cast<unsigned char>(*pos_) : EOF;
     }
-    return s;
+
+    // пропускает пробельные символы и читает следующий символ
+    bool ReadChar(char& c) {
+        while (pos_ != end_ && std::isspace(static_cast<unsigned char>(*pos_))) {
+            ++pos_;
+        }
+        if (pos_ == end_) {
+            return false;
+        }
+        c = *pos_++;
+        return true;
+    }
+
+    std::string_view ParseLiteral();
+    void ParseArray();
+    void ParseDict();
+    // строка и признак того, что она лежит не в буфере, а в unescaped_
+    std::pair<std::string_view, bool> ParseString();
+    void ParseBool();
+    void ParseNull();
+    void ParseNumber();
+};
+
+std::string_view Parser::ParseLiteral() {
+    const char* begin = pos_;
+    while (std::isalpha(Peek())) {
+        ++pos_;
+    }
+    return {begin, static_cast<size_t>(pos_ - begin)};
 }
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+void Parser::ParseArray() {
+    handler_.StartArray();
 
-    for (char c; input >> c && c != ']';) {
+    char c;
+    bool closed = false;
+    while (ReadChar(c)) {
+        if (c == ']') {
+            closed = true;
+            break;
+        }
         if (c != ',') {
-            input.putback(c);
+            --pos_;
         }
-        result.push_back(LoadNode(input));
+        ParseNode();
     }
-    if (!input) {
+    if (!closed) {
         throw ParsingError("Array parsing error"s);
     }
-    return Node(std::move(result));
+    handler_.EndArray();
 }
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+void Parser::ParseDict() {
+    handler_.StartDict();
 
-    for (char c; input >> c && c != '}';) {
+    char c;
+    bool closed = false;
+    while (ReadChar(c)) {
+        if (c == '}') {
+            closed = true;
+            break;
+        }
         if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
-                }
-                dict.emplace(std::move(key), LoadNode(input));
+            const auto [key, copy] = ParseString();
+            if (ReadChar(c) && c == ':') {
+                handler_.Key(key, copy);
+                ParseNode();
             } else {
                 throw ParsingError(": is expected but '"s + c + "' has been found"s);
             }
@@ -51,30 +119,40 @@ Node LoadDict(std::istream& input) {
             throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
         }
     }
-    if (!input) {
+    if (!closed) {
         throw ParsingError("Dictionary parsing error"s);
     }
-    return Node(std::move(dict));
+    handler_.EndDict();
 }
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
+std::pair<std::string_view, bool> Parser::ParseString() {
+    const char* begin = pos_;
+    while (pos_ != end_ && *pos_ != '"' && *pos_ != '\\' && *pos_ != '\n' && *pos_ != '\r') {
+        ++pos_;
+    }
+    if (pos_ != end_ && *pos_ == '"') {
+        const std::string_view value(begin, pos_ - begin);
+        ++pos_;
+        return {value, false};
+    }
+
+    // escape-последовательности раскрываются в отдельную строку
+    std::string& s = unescaped_;
+    s.assign(begin, pos_);
     while (true) {
-        if (it == end) {
+        if (pos_ == end_) {
             throw ParsingError("String parsing error");
         }
-        const char ch = *it;
+        const char ch = *pos_;
         if (ch == '"') {
-            ++it;
+            ++pos_;
             break;
         } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
+            ++pos_;
+            if (pos_ == end_) {
                 throw ParsingError("String parsing error");
             }
-            const char escaped_char = *(it);
+            const char escaped_char = *pos_;
             switch (escaped_char) {
                 case 'n':
                     s.push_back('\n');
@@ -99,58 +177,50 @@ Node LoadString(std::istream& input) {
         } else {
             s.push_back(ch);
         }
-        ++it;
+        ++pos_;
     }
 
-    return Node(std::move(s));
+    return {s, true};
 }
 
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
+void Parser::ParseBool() {
+    const auto s = ParseLiteral();
     if (s == "true"sv) {
-        return Node{true};
+        handler_.Bool(true);
     } else if (s == "false"sv) {
-        return Node{false};
+        handler_.Bool(false);
     } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+        throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
     }
 }
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{nullptr};
+void Parser::ParseNull() {
+    if (auto literal = ParseLiteral(); literal == "null"sv) {
+        handler_.Null();
     } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+        throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
     }
 }
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
-
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
-        }
-    };
+void Parser::ParseNumber() {
+    const char* begin = pos_;
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
+    // Считывает одну или более цифр
+    auto read_digits = [this] {
+        if (!std::isdigit(Peek())) {
             throw ParsingError("A digit is expected"s);
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        while (std::isdigit(Peek())) {
+            ++pos_;
         }
     };
 
-    if (input.peek() == '-') {
-        read_char();
+    if (Peek() == '-') {
+        ++pos_;
     }
     // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
+    if (Peek() == '0') {
+        ++pos_;
         // После 0 в JSON не могут идти другие цифры
     } else {
         read_digits();
@@ -158,67 +228,74 @@ Node LoadNumber(std::istream& input) {
 
     bool is_int = true;
     // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
+    if (Peek() == '.') {
+        ++pos_;
         read_digits();
         is_int = false;
     }
 
     // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    if (int ch = Peek(); ch == 'e' || ch == 'E') {
+        ++pos_;
+        if (ch = Peek(); ch == '+' || ch == '-') {
+            ++pos_;
         }
         read_digits();
         is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
+    if (is_int) {
+        // Целое, помещающееся в int64_t, разбираем на месте; при переполнении
+        // код ниже попробует преобразовать число в double
+        int64_t value = 0;
+        if (const auto [ptr, ec] = std::from_chars(begin, pos_, value); ec == std::errc{}) {
+            if (value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max()) {
+                handler_.Int(static_cast<int>(value));
+            } else {
+                handler_.Int64(value);
             }
+            return;
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
     }
+    double value = 0.;
+    if (const auto [ptr, ec] = std::from_chars(begin, pos_, value); ec != std::errc{}) {
+        throw ParsingError("Failed to convert "s + std::string(begin, pos_) + " to number"s);
+    }
+    handler_.Double(value);
 }
 
-Node LoadNode(std::istream& input) {
+void Parser::ParseNode() {
     char c;
-    if (!(input >> c)) {
+    if (!ReadChar(c)) {
         throw ParsingError("Unexpected EOF"s);
     }
     switch (c) {
         case '[':
-            return LoadArray(input);
+            ParseArray();
+            break;
         case '{':
-            return LoadDict(input);
-        case '"':
-            return LoadString(input);
+            ParseDict();
+            break;
+        case '"': {
+            const auto [value, copy] = ParseString();
+            handler_.String(value, copy);
+            break;
+        }
         case 't':
-            // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-            // подсказкой компилятору и человеку, что здесь программист явно задумывал
-            // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-            // написать break, return или throw.
-            // В данном случае, встретив t или f, переходим к попытке парсинга
-            // литералов true либо false
+            // Встретив t или f, переходим к попытке парсинга литералов true либо false
             [[fallthrough]];
         case 'f':
-            input.putback(c);
-            return LoadBool(input);
+            --pos_;
+            ParseBool();
+            break;
         case 'n':
-            input.putback(c);
-            return LoadNull(input);
+            --pos_;
+            ParseNull();
+            break;
         default:
-            input.putback(c);
-            return LoadNumber(input);
+            --pos_;
+            ParseNumber();
+            break;
     }
 }
 
@@ -245,7 +322,39 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
+// Числа выводятся через to_chars, без локали потока. Double — в формате
+// ostream по умолчанию (%g, 6 значащих цифр), чтобы ответы не менялись
+template <typename Number>
+void PrintNumber(Number value, std::ostream& out) {
+    char buffer[32];
+    const auto [end, ec] = std::to_chars(std::begin(buffer), std::end(buffer), value);
+    out.write(buffer, end - buffer);
+}
+
+template <>
+void PrintNumber<double>(double value, std::ostream& out) {
+    char buffer[32];
+    const auto [end, ec] = std::to_chars(std::begin(buffer), std::end(buffer), value,
+            std::chars_format::general, 6);
+    out.write(buffer, end - buffer);
+}
+
+template <>
+void PrintValue<int>(const int& value, const PrintContext& ctx) {
+    PrintNumber(value, ctx.out);
+}
+
+template <>
+void PrintValue<int64_t>(const int64_t& value, const PrintContext& ctx) {
+    PrintNumber(value, ctx.out);
+}
+
+template <>
+void PrintValue<double>(const double& value, const PrintContext& ctx) {
+    PrintNumber(value, ctx.out);
+}
+
+void PrintString(std::string_view value, std::ostream& out) {
     out.put('"');
     for (const char c : value) {
         switch (c) {
@@ -274,6 +383,11 @@ void PrintValue<std::string>(const std::string& value, const PrintContext& ctx)
     PrintString(value, ctx.out);
 }
 
+template <>
+void PrintValue<StringRef>(const StringRef& value, const PrintContext& ctx) {
+    PrintString(value.value, ctx.out);
+}
+
 template <>
 void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
     ctx.out << "null"sv;
@@ -338,14 +452,320 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
         node.GetValue());
 }
 
+// размер блока чтения потока, которого нельзя отобразить в память
+const size_t READ_CHUNK_SIZE = 1 << 20;
+
+// до такого размера словаря ключ ищется перебором
+const size_t LINEAR_SEARCH_SIZE = 8;
+
+// Интернированные ключи запросов и ответов справочника, по возрастанию
+const std::string_view KNOWN_KEYS[] = {
+    "allocations"sv, "arrive_by"sv, "base_requests"sv, "bus"sv, "bus_label_font_size"sv,
+    "bus_label_offset"sv, "bus_velocity"sv, "bus_wait_time"sv, "buses"sv, "bytes"sv, "capacity"sv,
+    "color_palette"sv, "count"sv, "curvature"sv, "distance"sv, "engine"sv, "error_message"sv,
+    "file"sv, "from"sv, "geo_distance"sv, "height"sv, "id"sv, "is_roundtrip"sv, "items"sv,
+    "latitude"sv, "limit"sv, "line_width"sv, "longitude"sv, "map"sv, "max_errors"sv,
+    "max_latitude"sv, "max_longitude"sv, "min_latitude"sv, "min_longitude"sv, "name"sv,
+    "origins"sv, "padding"sv, "precompute_router"sv, "progress"sv, "query"sv, "render_settings"sv,
+    "request_id"sv, "road_distance"sv, "road_distances"sv, "route_length"sv, "routing_settings"sv,
+    "serialization_settings"sv, "size"sv, "span_count"sv, "stat_requests"sv, "state"sv,
+    "stop_count"sv, "stop_label_font_size"sv, "stop_label_offset"sv, "stop_name"sv,
+    "stop_radius"sv, "stops"sv, "structures"sv, "table_build_time_budget"sv,
+    "table_memory_budget"sv, "time"sv, "to"sv, "total_allocations"sv, "total_bytes"sv,
+    "total_time"sv, "travel_times"sv, "type"sv, "underlayer_color"sv, "underlayer_width"sv,
+    "unique_stop_count"sv, "walking_radius"sv, "walking_velocity"sv, "width"sv,
+};
+
 }  // namespace
 
+InputBuffer::~InputBuffer() {
+#ifdef JSON_HAS_MMAP
+    if (mapped_ != nullptr) {
+        munmap(const_cast<char*>(mapped_), mapped_size_);
+    }
+#endif
+}
+
+std::shared_ptr<const InputBuffer> InputBuffer::FromFile(const std::string& path) {
+#ifdef JSON_HAS_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw ParsingError("Failed to open "s + path);
+    }
+    try {
+        auto buffer = FromDescriptor(fd);
+        close(fd);
+        return buffer;
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+#else
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw ParsingError("Failed to open "s + path);
+    }
+    return FromStream(input);
+#endif
+}
+
+std::shared_ptr<const InputBuffer> InputBuffer::FromStdin() {
+#ifdef JSON_HAS_MMAP
+    return FromDescriptor(STDIN_FILENO);
+#else
+    return FromStream(std::cin);
+#endif
+}
+
+std::shared_ptr<const InputBuffer> InputBuffer::FromStream(std::istream& input) {
+    auto buffer = std::make_shared<InputBuffer>();
+    std::string& data = buffer->data_;
+    size_t size = 0;
+    while (true) {
+        data.resize(size + READ_CHUNK_SIZE);
+        const auto count = input.rdbuf()->sgetn(data.data() + size, READ_CHUNK_SIZE);
+        if (count <= 0) {
+            break;
+        }
+        size += static_cast<size_t>(count);
+    }
+    data.resize(size);
+    return buffer;
+}
+
+std::shared_ptr<const InputBuffer> InputBuffer::FromDescriptor([[maybe_unused]] int fd) {
+    auto buffer = std::make_shared<InputBuffer>();
+#ifdef JSON_HAS_MMAP
+    // обычный файл отображаем в память целиком
+    struct stat info {};
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        const size_t size = static_cast<size_t>(info.st_size);
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+            madvise(mapped, size, MADV_SEQUENTIAL);
+            buffer->mapped_ = static_cast<const char*>(mapped);
+            buffer->mapped_size_ = size;
+            return buffer;
+        }
+    }
+
+    // канал, терминал или файл, который не удалось отобразить
+    std::string& data = buffer->data_;
+    size_t size = 0;
+    while (true) {
+        data.resize(size + READ_CHUNK_SIZE);
+        const ssize_t count = read(fd, data.data() + size, READ_CHUNK_SIZE);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count < 0) {
+            throw ParsingError("Failed to read input"s);
+        }
+        if (count == 0) {
+            break;
+        }
+        size += static_cast<size_t>(count);
+    }
+    data.resize(size);
+#endif
+    return buffer;
+}
+
+std::string_view InputBuffer::GetData() const {
+    if (mapped_ != nullptr) {
+        return {mapped_, mapped_size_};
+    }
+    return data_;
+}
+
+Key::Key(std::string key) {
+    if (const auto interned = Intern(key); interned.data() != nullptr) {
+        value_ = interned;
+    } else {
+        value_ = std::move(key);
+    }
+}
+
+Key Key::Ref(std::string_view key) {
+    Key result;
+    const auto interned = Intern(key);
+    result.value_ = interned.data() != nullptr ? interned : key;
+    return result;
+}
+
+std::string_view Key::Intern(std::string_view key) {
+    const auto iter = std::lower_bound(std::begin(KNOWN_KEYS), std::end(KNOWN_KEYS), key);
+    if (iter != std::end(KNOWN_KEYS) && *iter == key) {
+        return *iter;
+    }
+    return {};
+}
+
+const Node& Dict::at(std::string_view key) const {
+    const auto iter = find(key);
+    if (iter == end()) {
+        throw std::out_of_range("Key '"s + std::string(key) + "' not found"s);
+    }
+    return iter->second;
+}
+
+size_t Dict::count(std::string_view key) const {
+    return find(key) != end() ? 1 : 0;
+}
+
+Dict::const_iterator Dict::find(std::string_view key) const {
+    if (items_.size() <= LINEAR_SEARCH_SIZE) {
+        return std::find_if(items_.begin(), items_.end(), [key](const value_type& item) {
+            return item.first.View() == key;
+        });
+    }
+    const auto iter = LowerBound(key);
+    return iter != items_.end() && iter->first.View() == key ? iter : items_.end();
+}
+
+std::pair<Dict::const_iterator, bool> Dict::emplace(json::Key key, Node value) {
+    const auto iter = LowerBound(key);
+    if (iter != items_.end() && iter->first == key) {
+        return {iter, false};
+    }
+    return {items_.emplace(iter, std::move(key), std::move(value)), true};
+}
+
+Node& Dict::operator[](json::Key key) {
+    const auto iter = LowerBound(key);
+    if (iter != items_.end() && iter->first == key) {
+        return items_[iter - items_.begin()].second;
+    }
+    return items_.emplace(iter, std::move(key), Node{})->second;
+}
+
+bool Dict::operator==(const Dict& rhs) const {
+    return items_ == rhs.items_;
+}
+
+Dict::const_iterator Dict::LowerBound(std::string_view key) const {
+    return std::lower_bound(items_.begin(), items_.end(), key,
+            [](const value_type& item, std::string_view key) {
+                return item.first.View() < key;
+            });
+}
+
+void TreeBuilder::Null() {
+    AddValue(Node{nullptr});
+}
+
+void TreeBuilder::Bool(bool value) {
+    AddValue(Node{value});
+}
+
+void TreeBuilder::Int(int value) {
+    AddValue(Node{value});
+}
+
+void TreeBuilder::Int64(int64_t value) {
+    AddValue(Node{value});
+}
+
+void TreeBuilder::Double(double value) {
+    AddValue(Node{value});
+}
+
+void TreeBuilder::String(std::string_view value, bool copy) {
+    AddValue(copy ? Node{std::string(value)} : Node{StringRef{value}});
+}
+
+void TreeBuilder::StartArray() {
+    stack_.emplace_back();
+}
+
+void TreeBuilder::EndArray() {
+    Node value(std::move(stack_.back().array));
+    stack_.pop_back();
+    AddValue(std::move(value));
+}
+
+void TreeBuilder::StartDict() {
+    stack_.emplace_back().is_dict = true;
+}
+
+void TreeBuilder::Key(std::string_view key, bool copy) {
+    stack_.back().key = copy ? json::Key(std::string(key)) : json::Key::Ref(key);
+}
+
+void TreeBuilder::EndDict() {
+    auto& items = stack_.back().dict.items_;
+    const auto less = [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+        return lhs.first < rhs.first;
+    };
+    if (!std::is_sorted(items.begin(), items.end(), less)) {
+        std::stable_sort(items.begin(), items.end(), less);
+    }
+    const auto duplicate = std::adjacent_find(items.begin(), items.end(),
+            [](const Dict::value_type& lhs, const Dict::value_type& rhs) {
+                return lhs.first == rhs.first;
+            });
+    if (duplicate != items.end()) {
+        throw ParsingError("Duplicate key '"s + std::string(duplicate->first.View()) + "' have been found");
+    }
+
+    Node value(std::move(stack_.back().dict));
+    stack_.pop_back();
+    AddValue(std::move(value));
+}
+
+Node TreeBuilder::Extract() {
+    return std::move(root_);
+}
+
+void TreeBuilder::AddValue(Node value) {
+    if (stack_.empty()) {
+        root_ = std::move(value);
+        return;
+    }
+    Frame& frame = stack_.back();
+    if (frame.is_dict) {
+        frame.dict.items_.emplace_back(std::move(*frame.key), std::move(value));
+    } else {
+        frame.array.push_back(std::move(value));
+    }
+}
+
+void Parse(std::string_view data, Handler& handler) {
+    Parser(data, handler).ParseNode();
+}
+
+Document Load(std::shared_ptr<const InputBuffer> buffer) {
+    TreeBuilder builder;
+    Parse(buffer->GetData(), builder);
+    return Document{builder.Extract(), std::move(buffer)};
+}
+
 Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+    return Load(InputBuffer::FromStream(input));
 }
 
 void Print(const Document& doc, std::ostream& output) {
     PrintNode(doc.GetRoot(), PrintContext{output});
 }
 
+ArrayPrinter::ArrayPrinter(std::ostream& output)
+    : output_(output) {
+    output_ << "[\n"sv;
+}
+
+void ArrayPrinter::Add(const Node& node) {
+    if (first_) {
+        first_ = false;
+    } else {
+        output_ << ",\n"sv;
+    }
+    const auto inner_ctx = PrintContext{output_}.Indented();
+    inner_ctx.PrintIndent();
+    PrintNode(node, inner_ctx);
+}
+
+void ArrayPrinter::Finish() {
+    output_ << "\n]"sv;
+}
+
 }  // namespace json
\ No newline at end of file
@@ -1,24 +1,126 @@
 #pragma once
 
+#include <cstdint>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
 using Array = std::vector<Node>;
 
+// Ключ словаря. Ключи из постоянного набора ключей запросов и ответов интернированы:
+// хранится ссылка на общую строку. Ключи во входном буфере тоже хранятся ссылкой,
+// остальные — собственной строкой
+class Key {
+public:
+    Key(std::string key);
+
+    Key(const char* key)
+        : Key(std::string(key)) {
+    }
+
+    // key должен жить дольше ключа, если он не интернирован
+    static Key Ref(std::string_view key);
+
+    std::string_view View() const {
+        if (const auto* ref = std::get_if<std::string_view>(&value_)) {
+            return *ref;
+        }
+        return std::get<std::string>(value_);
+    }
+
+    operator std::string_view() const {
+        return View();
+    }
+
+    bool operator==(const Key& rhs) const {
+        return View() == rhs.View();
+    }
+
+    bool operator<(const Key& rhs) const {
+        return View() < rhs.View();
+    }
+
+private:
+    std::variant<std::string_view, std::string> value_;
+
+    Key() = default;
+
+    // интернированная строка, равная key, либо пустая ссылка
+    static std::string_view Intern(std::string_view key);
+};
+
+// Словарь — вектор пар, упорядоченный по ключам. Обход и вывод идут в порядке ключей,
+// как у std::map, но под каждый ключ не выделяется отдельный узел. В небольших
+// словарях ключ ищется перебором, в крупных — двоичным поиском
+class Dict {
+public:
+    using value_type = std::pair<Key, Node>;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    // бросает std::out_of_range, если ключа нет
+    const Node& at(std::string_view key) const;
+
+    size_t count(std::string_view key) const;
+
+    const_iterator find(std::string_view key) const;
+
+    // вставляет пару, если такого ключа ещё нет
+    std::pair<const_iterator, bool> emplace(Key key, Node value);
+
+    Node& operator[](Key key);
+
+    const_iterator begin() const {
+        return items_.begin();
+    }
+
+    const_iterator end() const {
+        return items_.end();
+    }
+
+    size_t size() const {
+        return items_.size();
+    }
+
+    bool empty() const {
+        return items_.empty();
+    }
+
+    bool operator==(const Dict& rhs) const;
+
+private:
+    std::vector<value_type> items_;
+
+    // TreeBuilder дописывает пары без упорядочивания и упорядочивает их один раз
+    friend class TreeBuilder;
+
+    const_iterator LowerBound(std::string_view key) const;
+};
+
+// Строка без escape-последовательностей, лежащая в чужом буфере: во входном буфере
+// документа или в блоке названий базы. Действительна, пока существует этот буфер
+struct StringRef {
+    std::string_view value;
+
+    bool operator==(const StringRef& rhs) const {
+        return value == rhs.value;
+    }
+};
+
 class ParsingError : public std::runtime_error {
 public:
     using runtime_error::runtime_error;
 };
 
 class Node final
-    : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+    : private std::variant<std::nullptr_t, Array, Dict, bool, int, int64_t, double, std::string, StringRef> {
 public:
     using variant::variant;
     using Value = variant;
@@ -34,18 +136,30 @@ public:
         return std::get<int>(*this);
     }
 
+    // целое, не помещающееся в int, хранится как int64_t
+    bool IsInt64() const {
+        return IsInt() || std::holds_alternative<int64_t>(*this);
+    }
+    int64_t AsInt64() const {
+        using namespace std::literals;
+        if (!IsInt64()) {
+            throw std::logic_error("Not an int64"s);
+        }
+        return IsInt() ? AsInt() : std::get<int64_t>(*this);
+    }
+
     bool IsPureDouble() const {
         return std::holds_alternative<double>(*this);
     }
     bool IsDouble() const {
-        return IsInt() || IsPureDouble();
+        return IsInt64() || IsPureDouble();
     }
     double AsDouble() const {
         using namespace std::literals;
         if (!IsDouble()) {
             throw std::logic_error("Not a double"s);
         }
-        return IsPureDouble() ? std::get<double>(*this) : AsInt();
+        return IsPureDouble() ? std::get<double>(*this) : static_cast<double>(AsInt64());
     }
 
     bool IsBool() const {
@@ -77,15 +191,17 @@ public:
     }
 
     bool IsString() const {
-        return std::holds_alternative<std::string>(*this);
+        return std::holds_alternative<std::string>(*this) || std::holds_alternative<StringRef>(*this);
     }
-    const std::string& AsString() const {
+    std::string_view AsString() const {
         using namespace std::literals;
-        if (!IsString()) {
-            throw std::logic_error("Not a string"s);
+        if (const auto* str = std::get_if<std::string>(this)) {
+            return *str;
         }
-
-        return std::get<std::string>(*this);
+        if (const auto* str = std::get_if<StringRef>(this)) {
+            return str->value;
+        }
+        throw std::logic_error("Not a string"s);
     }
 
     bool IsDict() const {
@@ -100,7 +216,14 @@ public:
         return std::get<Dict>(*this);
     }
 
+    // строки и целые равны независимо от того, в каком виде они хранятся
     bool operator==(const Node& rhs) const {
+        if (IsString() && rhs.IsString()) {
+            return AsString() == rhs.AsString();
+        }
+        if (IsInt64() && rhs.IsInt64()) {
+            return AsInt64() == rhs.AsInt64();
+        }
         return GetValue() == rhs.GetValue();
     }
 
@@ -113,10 +236,40 @@ inline bool operator!=(const Node& lhs, const Node& rhs) {
     return !(lhs == rhs);
 }
 
+// Входные данные целиком в памяти: отображённый файл либо прочитанный поток
+class InputBuffer {
+public:
+    InputBuffer() = default;
+    InputBuffer(const InputBuffer&) = delete;
+    InputBuffer& operator=(const InputBuffer&) = delete;
+    ~InputBuffer();
+
+    // отображает файл в память
+    static std::shared_ptr<const InputBuffer> FromFile(const std::string& path);
+
+    // Стандартный ввод: перенаправленный файл отображается в память,
+    // канал или терминал читается крупными блоками
+    static std::shared_ptr<const InputBuffer> FromStdin();
+
+    // читает поток до конца крупными блоками
+    static std::shared_ptr<const InputBuffer> FromStream(std::istream& input);
+
+    std::string_view GetData() const;
+
+private:
+    std::string data_;
+    const char* mapped_ = nullptr;
+    size_t mapped_size_ = 0;
+
+    static std::shared_ptr<const InputBuffer> FromDescriptor(int fd);
+};
+
 class Document {
 public:
-    explicit Document(Node root)
-        : root_(std::move(root)) {
+    // строки StringRef из root ссылаются на buffer
+    explicit Document(Node root, std::shared_ptr<const InputBuffer> buffer = nullptr)
+        : buffer_(std::move(buffer))
+        , root_(std::move(root)) {
     }
 
     const Node& GetRoot() const {
@@ -124,6 +277,7 @@ public:
     }
 
 private:
+    std::shared_ptr<const InputBuffer> buffer_;
     Node root_;
 };
 
@@ -135,8 +289,83 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+// Обработчик событий потокового разбора. Строка или ключ с copy == false лежит
+// во входном буфере и действительна вместе с ним, с copy == true — только во время вызова
+class Handler {
+public:
+    virtual ~Handler() = default;
+
+    virtual void Null() = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Int(int value) = 0;
+    // целое, не помещающееся в int
+    virtual void Int64(int64_t value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void String(std::string_view value, bool copy) = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void StartDict() = 0;
+    virtual void Key(std::string_view key, bool copy) = 0;
+    virtual void EndDict() = 0;
+};
+
+// Собирает из событий дерево узлов. Строки без copy становятся StringRef
+class TreeBuilder final : public Handler {
+public:
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Int64(int64_t value) override;
+    void Double(double value) override;
+    void String(std::string_view value, bool copy) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void Key(std::string_view key, bool copy) override;
+    void EndDict() override;
+
+    // собранный узел верхнего уровня
+    Node Extract();
+
+private:
+    // незакрытый массив или словарь
+    struct Frame {
+        bool is_dict = false;
+        Array array;
+        Dict dict;
+        std::optional<json::Key> key;
+    };
+
+    std::vector<Frame> stack_;
+    Node root_;
+
+    void AddValue(Node value);
+};
+
+// Разбирает одно значение из data указателями, сообщая о нём событиями handler
+void Parse(std::string_view data, Handler& handler);
+
+// Строит дерево, не копируя строки без escape-последовательностей
+Document Load(std::shared_ptr<const InputBuffer> buffer);
+
 Document Load(std::istream& input);
 
 void Print(const Document& doc, std::ostream& output);
 
+// Выводит массив верхнего уровня по одному элементу, не собирая его целиком.
+// Вывод совпадает с Print документа из того же массива
+class ArrayPrinter {
+public:
+    explicit ArrayPrinter(std::ostream& output);
+
+    void Add(const Node& node);
+
+    // закрывает массив
+    void Finish();
+
+private:
+    std::ostream& output_;
+    bool first_ = true;
+};
+
 }  // namespace json
\ No newline at end of file
@@ -32,7 +32,7 @@ Builder& Builder::Value(Node::Value value) {
 		nodes_stack_.emplace_back(std::make_unique<Node>(std::move(array)));
 
 	} else { // для словаря, для которого уже подготовлен ключ
-		std::string key = std::move(nodes_stack_.back()->AsString());
+		std::string key(nodes_stack_.back()->AsString());
 		nodes_stack_.pop_back();
 		if (!nodes_stack_.back()->IsDict()) {
 			throw std::logic_error("Expected Dictionary");
@@ -22,12 +22,18 @@ private:
 		Node operator() (std::string&& value) const {
 			return Node(std::move(value));
 		}
+		Node operator() (StringRef&& value) const {
+			return Node(value);
+		}
 		Node operator() (bool&& value) const {
 			return Node(value);
 		}
 		Node operator() (int&& value) const {
 			return Node(value);
 		}
+		Node operator() (int64_t&& value) const {
+			return Node(value);
+		}
 		Node operator() (double&& value) const {
 			return Node(value);
 		}
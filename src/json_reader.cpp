@@ -1,10 +1,14 @@
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <deque>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -20,6 +24,7 @@
 #include "json_builder.h"
 #include "json.h"
 #include "map_renderer.h"
+#include "memory_usage.h"
 #include "request_handler.h"
 #include "router.h"
 #include "serialization.h"
@@ -39,7 +44,7 @@ struct EdgeInfoGetter {
 		using namespace std::literals;
 		return json::Builder{}.StartDict()
 								.Key("type"s).Value("Wait"s)
-								.Key("stop_name"s).Value(std::string(edge_info.stop_name))
+								.Key("stop_name"s).Value(std::string(edge_info.stop->name))
 								.Key("time").Value(edge_info.time)
 							.EndDict()
 							.Build();
@@ -49,60 +54,319 @@ struct EdgeInfoGetter {
 		using namespace std::literals;
 		return json::Builder{}.StartDict()
 								.Key("type"s).Value("Bus"s)
-								.Key("bus"s).Value(std::string(edge_info.bus_name))
+								.Key("bus"s).Value(std::string(edge_info.bus->name))
 								.Key("span_count"s).Value(static_cast<int>(edge_info.span_count))
 								.Key("time").Value(edge_info.time)
 							.EndDict()
 							.Build();
 	}
+
+	json::Node operator()(const transport_router::WalkEdgeInfo& edge_info) {
+		using namespace std::literals;
+		return json::Builder{}.StartDict()
+								.Key("type"s).Value("Walk"s)
+								.Key("from"s).Value(std::string(edge_info.from->name))
+								.Key("to"s).Value(std::string(edge_info.to->name))
+								.Key("time").Value(edge_info.time)
+							.EndDict()
+							.Build();
+	}
 };
 
 }  // namespace detail
 
 namespace request_parser {
 
-domain::Stop ParseStop(const json::Dict& request) {
-	using namespace std::literals;
-	return domain::Stop{
-		request.at("name"s).AsString(),
-		geo::Coordinates{request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble()}
+// Потоковый разбор base_requests: запросы сразу превращаются в записи CatalogueData,
+// дерево узлов не строится. Остановки маршрутов связываются по названиям вторым
+// проходом в TransportCatalogue::Load, поэтому маршрут может ссылаться на остановку,
+// описанную позже. Названия ссылаются на входной буфер
+class BaseRequestsHandler final : public json::Handler {
+public:
+	void Null() override {
+	}
+
+	void Bool(bool value) override {
+		if (depth_ == REQUEST_DEPTH && field_ == Field::IS_ROUNDTRIP) {
+			request_.is_roundtrip = value;
+		}
+	}
+
+	void Int(int value) override {
+		Int64(value);
+	}
+
+	void Int64(int64_t value) override {
+		if (depth_ == FIELD_DEPTH && field_ == Field::ROAD_DISTANCES) {
+			request_.distances.push_back({{}, destination_, static_cast<uint64_t>(value)});
+		} else {
+			Double(static_cast<double>(value));
+		}
+	}
+
+	void Double(double value) override {
+		if (depth_ != REQUEST_DEPTH) {
+			return;
+		}
+		if (field_ == Field::LATITUDE) {
+			request_.latitude = value;
+		} else if (field_ == Field::LONGITUDE) {
+			request_.longitude = value;
+		}
+	}
+
+	void String(std::string_view value, bool copy) override {
+		if (depth_ == REQUEST_DEPTH && field_ == Field::TYPE) {
+			request_.type = Store(value, copy);
+		} else if (depth_ == REQUEST_DEPTH && field_ == Field::NAME) {
+			request_.name = Store(value, copy);
+		} else if (depth_ == FIELD_DEPTH && field_ == Field::STOPS) {
+			request_.stops.push_back(Store(value, copy));
+		}
+	}
+
+	void StartArray() override {
+		if (++depth_ == FIELD_DEPTH && field_ == Field::STOPS) {
+			request_.has_stops = true;
+		}
+	}
+
+	void EndArray() override {
+		--depth_;
+	}
+
+	void StartDict() override {
+		using namespace std::literals;
+		++depth_;
+		if (depth_ == LIST_DEPTH) {
+			throw std::invalid_argument("base_requests must be an array"s);
+		} else if (depth_ == REQUEST_DEPTH) {
+			request_ = {};
+			field_ = Field::NONE;
+		} else if (depth_ == FIELD_DEPTH && field_ == Field::ROAD_DISTANCES) {
+			request_.has_road_distances = true;
+		}
+	}
+
+	void Key(std::string_view key, bool copy) override {
+		if (depth_ == REQUEST_DEPTH) {
+			field_ = GetField(key);
+		} else if (depth_ == FIELD_DEPTH && field_ == Field::ROAD_DISTANCES) {
+			destination_ = Store(key, copy);
+		}
+	}
+
+	void EndDict() override {
+		if (depth_ == REQUEST_DEPTH) {
+			FinishRequest();
+		}
+		--depth_;
+	}
+
+	CatalogueData ExtractCatalogueData() {
+		return std::move(data_);
+	}
+
+private:
+	// глубина вложенности: список запросов, запрос, road_distances или stops
+	static constexpr int LIST_DEPTH = 1;
+	static constexpr int REQUEST_DEPTH = 2;
+	static constexpr int FIELD_DEPTH = 3;
+
+	enum class Field {
+		NONE,
+		TYPE,
+		NAME,
+		LATITUDE,
+		LONGITUDE,
+		ROAD_DISTANCES,
+		IS_ROUNDTRIP,
+		STOPS,
 	};
-}
 
-std::deque<domain::FromToDistance>
-ParseStopsDistances(const json::Dict& request) {
-	using namespace std::literals;
+	// поля разбираемого запроса; порядок ключей в запросе произвольный
+	struct Request {
+		std::optional<std::string_view> type;
+		std::optional<std::string_view> name;
+		std::optional<double> latitude;
+		std::optional<double> longitude;
+		std::optional<bool> is_roundtrip;
+		bool has_road_distances = false;
+		bool has_stops = false;
+		// from заполняется по завершении запроса: name может идти после road_distances
+		std::vector<domain::FromToDistance> distances;
+		std::vector<std::string_view> stops;
+	};
 
-	std::string_view start = request.at("name"s).AsString();
+	CatalogueData data_;
+	std::deque<std::string> copied_; // строки с escape-последовательностями
+	Request request_;
+	int depth_ = 0;
+	Field field_ = Field::NONE;
+	std::string_view destination_;
 
-	std::deque<domain::FromToDistance> result;
-	for (const auto& [destination, distance] : request.at("road_distances"s).AsDict()) {
-		result.emplace_back(domain::FromToDistance{
-			start, destination, static_cast<uint64_t>(distance.AsInt())});
+	static Field GetField(std::string_view key) {
+		using namespace std::literals;
+		if (key == "type"sv) {
+			return Field::TYPE;
+		} else if (key == "name"sv) {
+			return Field::NAME;
+		} else if (key == "latitude"sv) {
+			return Field::LATITUDE;
+		} else if (key == "longitude"sv) {
+			return Field::LONGITUDE;
+		} else if (key == "road_distances"sv) {
+			return Field::ROAD_DISTANCES;
+		} else if (key == "is_roundtrip"sv) {
+			return Field::IS_ROUNDTRIP;
+		} else if (key == "stops"sv) {
+			return Field::STOPS;
+		}
+		return Field::NONE;
 	}
 
-	return result;
-}
+	std::string_view Store(std::string_view value, bool copy) {
+		if (!copy) {
+			return value;
+		}
+		return copied_.emplace_back(value);
+	}
 
-domain::Bus ParseBus(const json::Dict& request,
-		const TransportCatalogue& transport_catalogue) {
-	using namespace std::literals;
+	static void Require(bool present, std::string_view field) {
+		using namespace std::literals;
+		if (!present) {
+			throw std::invalid_argument("Missing field "s + std::string(field) + " in base request"s);
+		}
+	}
 
-	domain::Bus bus;
+	void FinishRequest() {
+		using namespace std::literals;
+		Require(request_.type.has_value(), "type"sv);
+		if (*request_.type == "Stop"sv) {
+			Require(request_.name.has_value(), "name"sv);
+			Require(request_.latitude.has_value(), "latitude"sv);
+			Require(request_.longitude.has_value(), "longitude"sv);
+			Require(request_.has_road_distances, "road_distances"sv);
+			data_.stops.push_back(domain::Stop{
+				*request_.name, geo::Coordinates{*request_.latitude, *request_.longitude}});
+			for (auto& distance : request_.distances) {
+				distance.from = *request_.name;
+				data_.distances.push_back(distance);
+			}
+		} else if (*request_.type == "Bus"sv) {
+			Require(request_.name.has_value(), "name"sv);
+			Require(request_.is_roundtrip.has_value(), "is_roundtrip"sv);
+			Require(request_.has_stops, "stops"sv);
+			data_.buses.push_back(domain::BusByStopNames{
+				*request_.name, *request_.is_roundtrip, std::move(request_.stops)});
+		}
+	}
+};
 
-	bus.name = request.at("name"s).AsString();
-	bus.is_circle = request.at("is_roundtrip"s).AsBool();
-	for (const auto& stop_name : request.at("stops"s).AsArray()) {
-		const auto stop = transport_catalogue.FindStop(stop_name.AsString());
-		bus.route.push_back(stop);
+// Входные данные make_base: base_requests разбираются потоково в BaseRequestsHandler,
+// остальные, небольшие, разделы собираются в дерево узлов
+class MakeBaseHandler final : public json::Handler {
+public:
+	void Null() override {
+		Target().Null();
+		FinishScalar();
 	}
 
-	return bus;
-}
+	void Bool(bool value) override {
+		Target().Bool(value);
+		FinishScalar();
+	}
+
+	void Int(int value) override {
+		Target().Int(value);
+		FinishScalar();
+	}
+
+	void Int64(int64_t value) override {
+		Target().Int64(value);
+		FinishScalar();
+	}
+
+	void Double(double value) override {
+		Target().Double(value);
+		FinishScalar();
+	}
+
+	void String(std::string_view value, bool copy) override {
+		Target().String(value, copy);
+		FinishScalar();
+	}
+
+	void StartArray() override {
+		Target().StartArray();
+		++depth_;
+	}
+
+	void EndArray() override {
+		--depth_;
+		Target().EndArray();
+		FinishScalar();
+	}
+
+	void StartDict() override {
+		Target().StartDict();
+		++depth_;
+	}
+
+	void Key(std::string_view key, bool copy) override {
+		using namespace std::literals;
+		if (depth_ == 1 && key == "base_requests"sv) {
+			in_base_requests_ = true;
+			has_base_requests_ = true;
+			return;
+		}
+		Target().Key(key, copy);
+	}
+
+	void EndDict() override {
+		--depth_;
+		Target().EndDict();
+		FinishScalar();
+	}
+
+	bool HasBaseRequests() const {
+		return has_base_requests_;
+	}
+
+	// разделы входных данных, кроме base_requests
+	json::Node ExtractCommands() {
+		return commands_.Extract();
+	}
+
+	CatalogueData ExtractCatalogueData() {
+		return base_requests_.ExtractCatalogueData();
+	}
+
+private:
+	json::TreeBuilder commands_;
+	BaseRequestsHandler base_requests_;
+	int depth_ = 0;
+	bool in_base_requests_ = false;
+	bool has_base_requests_ = false;
+
+	json::Handler& Target() {
+		if (in_base_requests_) {
+			return base_requests_;
+		}
+		return commands_;
+	}
+
+	// значение раздела верхнего уровня разобрано целиком
+	void FinishScalar() {
+		if (depth_ == 1) {
+			in_base_requests_ = false;
+		}
+	}
+};
 
 svg::Color ParseColor(const json::Node& color) {
 	if (color.IsString()) {
-		return color.AsString();
+		return std::string(color.AsString());
 	}
 	if (color.IsArray()) {
 		const auto& color_arr = color.AsArray();
@@ -149,6 +413,19 @@ ParseRenderSettings(const json::Dict& render_settings) {
 	return result;
 }
 
+transport_router::RoutingEngine ParseRoutingEngine(std::string_view engine) {
+	using namespace std::literals;
+
+	if (engine == "auto"sv) {
+		return transport_router::RoutingEngine::AUTO;
+	} else if (engine == "table"sv) {
+		return transport_router::RoutingEngine::TABLE;
+	} else if (engine == "search"sv) {
+		return transport_router::RoutingEngine::SEARCH;
+	}
+	throw std::logic_error("Wrong routing engine");
+}
+
 transport_router::RoutingSettings ParseRoutingSettings(const json::Dict& routing_settings) {
 	using namespace std::literals;
 
@@ -156,48 +433,29 @@ transport_router::RoutingSettings ParseRoutingSettings(const json::Dict& routing
 
 	result.bus_wait_time = routing_settings.at("bus_wait_time"s).AsDouble();
 	result.bus_velocity = routing_settings.at("bus_velocity"s).AsDouble();
-
-	return result;
-}
-
-}  // request_parser
-
-namespace add {
-
-void Stops(const json::Array& base_requests,
-		TransportCatalogue& transport_catalogue) {
-	using namespace std::literals;
-
-	for (auto& request : base_requests) {
-		if (request.AsDict().at("type"s) == "Stop"s) {
-			transport_catalogue.AddStop(std::move(request_parser::ParseStop(request.AsDict())));
-		}
+	if (routing_settings.count("precompute_router"s)) {
+		result.precompute_router = routing_settings.at("precompute_router"s).AsBool();
 	}
-}
-
-void StopsDistances(const json::Array& base_requests,
-		TransportCatalogue& transport_catalogue) {
-	using namespace std::literals;
-
-	for (auto& request : base_requests) {
-		if (request.AsDict().at("type"s) == "Stop"s) {
-			transport_catalogue.AddStopsDistances(request_parser::ParseStopsDistances(request.AsDict()));
-		}
+	if (routing_settings.count("engine"s)) {
+		result.engine = ParseRoutingEngine(routing_settings.at("engine"s).AsString());
 	}
-}
-
-void Buses(const json::Array& base_requests,
-		TransportCatalogue& transport_catalogue) {
-	using namespace std::literals;
-
-	for (auto& request : base_requests) {
-		if (request.AsDict().at("type"s) == "Bus"s) {
-			transport_catalogue.AddBus(std::move(request_parser::ParseBus(request.AsDict(), transport_catalogue)));
-		}
+	if (routing_settings.count("table_memory_budget"s)) {
+		result.table_memory_budget = routing_settings.at("table_memory_budget"s).AsDouble();
+	}
+	if (routing_settings.count("table_build_time_budget"s)) {
+		result.table_build_time_budget = routing_settings.at("table_build_time_budget"s).AsDouble();
+	}
+	if (routing_settings.count("walking_radius"s)) {
+		result.walking_radius = routing_settings.at("walking_radius"s).AsDouble();
 	}
+	if (routing_settings.count("walking_velocity"s)) {
+		result.walking_velocity = routing_settings.at("walking_velocity"s).AsDouble();
+	}
+
+	return result;
 }
 
-}  // namespace add
+}  // request_parser
 
 namespace make_stat {
 
@@ -217,7 +475,7 @@ json::Node Bus(const json::Dict& request,
 			return Builder{}.StartDict()
 								.Key("curvature"s).Value(bus_stat->curvature)
 								.Key("request_id"s).Value(request.at("id"s).AsInt())
-								.Key("route_length"s).Value(static_cast<int>(bus_stat->route_length))
+								.Key("route_length"s).Value(static_cast<int64_t>(bus_stat->route_length))
 								.Key("stop_count"s).Value(static_cast<int>(bus_stat->stop_count))
 								.Key("unique_stop_count"s).Value(static_cast<int>(bus_stat->unique_stop_count))
 							.EndDict()
@@ -231,23 +489,18 @@ json::Node Stop(const json::Dict& request,
 	using namespace std::literals;
 	using namespace json;
 
-	std::set<std::string_view> sorted_bus_names;
-	{
-		const auto& buses = request_handler.GetBusesByStop(request.at("name"s).AsString());
-		if (!buses.has_value()) {
-			return Builder{}.StartDict()
-								.Key("request_id"s).Value(request.at("id"s).AsInt())
-								.Key("error_message"s).Value("not found"s)
-							.EndDict()
-							.Build();
-		}
-		for (const auto bus : *buses) {
-			sorted_bus_names.insert(bus->name);
-		}
+	const auto& bus_ids = request_handler.GetBusesByStop(request.at("name"s).AsString());
+	if (!bus_ids.has_value()) {
+		return Builder{}.StartDict()
+							.Key("request_id"s).Value(request.at("id"s).AsInt())
+							.Key("error_message"s).Value("not found"s)
+						.EndDict()
+						.Build();
 	}
+	const auto& transport_catalogue = request_handler.GetTransportCatalogue();
 	Array result;
-	for (const auto bus_name : sorted_bus_names) {
-		result.push_back(Node{std::string(bus_name)});
+	for (const auto bus_id : *bus_ids) {
+		result.push_back(Node{std::string(transport_catalogue.GetBus(bus_id)->name)});
 	}
 
 	return Builder{}.StartDict()
@@ -303,13 +556,6 @@ json::Node Route(const json::Dict& request,
 
 namespace fill {
 
-void TransportCatalogue(const json::Array& base_requests,
-		transport_catalogue::TransportCatalogue& transport_catalogue) {
-	add::Stops(base_requests, transport_catalogue);
-	add::StopsDistances(base_requests, transport_catalogue);
-	add::Buses(base_requests, transport_catalogue);
-}
-
 void MapRenderer(const json::Dict& render_settings,
 		renderer::MapRenderer& map_renderer,
 		transport_catalogue::TransportCatalogue& transport_catalogue) {
@@ -335,7 +581,7 @@ void MakeStatAnswer(std::ostream& output, const json::Array& stat_requests,
 
 	Array result;
 	for (const auto& request : stat_requests) {
-		const std::string& type = request.AsDict().at("type"s).AsString();
+		const std::string_view type = request.AsDict().at("type"s).AsString();
 		if (type == "Bus"s) {
 			result.emplace_back(make_stat::Bus(request.AsDict(), request_handler));
 		} else if (type == "Stop"s) {
@@ -364,25 +610,44 @@ json::Node ConvertEdgeInfo(const transport_router_proto::EdgeInfo& edge_info,
 	switch(edge_info.edge_info_case()) {
 		case transport_router_proto::EdgeInfo::EdgeInfoCase::kWaitEdgeInfo : {
 			const auto& source = edge_info.wait_edge_info();
-			std::string_view stop_name = request_handler.GetTransportCatalogue().stop(source.stop_id()).name();
+			const auto& transport_catalogue = request_handler.GetTransportCatalogue();
+			const std::string_view stop_name = serialization::GetName(transport_catalogue,
+					transport_catalogue.stop(source.stop_id()));
 			return json::Builder{}.StartDict()
 									.Key("type"s).Value("Wait"s)
-									.Key("stop_name"s).Value(std::string(stop_name))
+									.Key("stop_name"s).Value(json::StringRef{stop_name})
 									.Key("time").Value(source.minutes())
 								.EndDict()
 								.Build();
 		}
 		case transport_router_proto::EdgeInfo::EdgeInfoCase::kBusEdgeInfo : {
 			const auto& source = edge_info.bus_edge_info();
-			std::string_view bus_name = request_handler.GetTransportCatalogue().bus(source.bus_id()).name();
+			const auto& transport_catalogue = request_handler.GetTransportCatalogue();
+			const std::string_view bus_name = serialization::GetName(transport_catalogue,
+					transport_catalogue.bus(source.bus_id()));
 			return json::Builder{}.StartDict()
 									.Key("type"s).Value("Bus"s)
-									.Key("bus"s).Value(std::string(bus_name))
+									.Key("bus"s).Value(json::StringRef{bus_name})
 									.Key("span_count"s).Value(static_cast<int>(source.span_count()))
 									.Key("time").Value(source.minutes())
 								.EndDict()
 								.Build();
 		}
+		case transport_router_proto::EdgeInfo::EdgeInfoCase::kWalkEdgeInfo : {
+			const auto& source = edge_info.walk_edge_info();
+			const auto& transport_catalogue = request_handler.GetTransportCatalogue();
+			return json::Builder{}.StartDict()
+									.Key("type"s).Value("Walk"s)
+									.Key("from"s).Value(json::StringRef{serialization::GetName(transport_catalogue,
+											transport_catalogue.stop(source.from_stop_id()))})
+									.Key("to"s).Value(json::StringRef{serialization::GetName(transport_catalogue,
+											transport_catalogue.stop(source.to_stop_id()))})
+									.Key("time").Value(source.minutes())
+								.EndDict()
+								.Build();
+		}
+		case transport_router_proto::EdgeInfo::EdgeInfoCase::EDGE_INFO_NOT_SET :
+			break;
 	}
 
 	return {};
@@ -466,43 +731,12 @@ renderer::RenderSettings RenderSettings(
 
 namespace load {
 
-domain::Stop Stop(const transport_catalogue_proto::Stop& proto_stop) {
-	domain::Stop stop;
-	stop.name = proto_stop.name();
-	stop.coordinates.lat = proto_stop.coordinates().lat();
-	stop.coordinates.lng = proto_stop.coordinates().lng();
-	return stop;
-}
-
-domain::Bus MakeBus(const transport_catalogue_proto::Bus& proto_bus, const std::deque<domain::StopPtr> route) {
-	domain::Bus bus;
-	bus.name = proto_bus.name();
-	bus.is_circle = proto_bus.is_circle();
-	bus.route = std::move(route);
-	return bus;
-}
-
-std::deque<domain::Bus> MakeBuses(const transport_catalogue_proto::TransportCatalogue& transport_catalogue,
-		const std::deque<domain::Stop>& stops) {
-	std::deque<domain::Bus> buses;
-	for (const auto& proto_bus : transport_catalogue.bus()) {
-		std::deque<domain::StopPtr> route;
-		for (const auto& stop_id : proto_bus.stop_id()) {
-			const std::string& stop_name = transport_catalogue.stop(stop_id).name();
-			const auto stop_iter = std::find_if(stops.begin(), stops.end(),
-					[&stop_name](const domain::Stop& stop) { return stop.name == stop_name; }
-					);
-			route.emplace_back(&(*stop_iter));
-		}
-		buses.emplace_back(std::move(MakeBus(proto_bus, std::move(route))));
-	}
-	return buses;
-}
-
 transport_router::RoutingSettings RoutingSettings(const transport_router_proto::RoutingSettings& settings) {
 	transport_router::RoutingSettings result;
 	result.bus_wait_time = settings.bus_wait_time();
 	result.bus_velocity = settings.bus_velocity();
+	result.walking_radius = settings.walking_radius();
+	result.walking_velocity = settings.walking_velocity();
 	return result;
 }
 
@@ -541,7 +775,7 @@ json::Node Bus(const json::Dict& request,
 			return Builder{}.StartDict()
 								.Key("curvature"s).Value(bus_stat->curvature())
 								.Key("request_id"s).Value(request.at("id"s).AsInt())
-								.Key("route_length"s).Value(static_cast<int>(bus_stat->route_length()))
+								.Key("route_length"s).Value(static_cast<int64_t>(bus_stat->route_length()))
 								.Key("stop_count"s).Value(static_cast<int>(bus_stat->stop_count()))
 								.Key("unique_stop_count"s).Value(static_cast<int>(bus_stat->unique_stop_count()))
 							.EndDict()
@@ -555,9 +789,9 @@ json::Node Stop(const json::Dict& request,
 	using namespace std::literals;
 	using namespace json;
 
-	const auto& sorted_bus_names = request_handler.GetBusesByStop(request.at("name"s).AsString());
+	const auto& bus_ids = request_handler.GetBusesByStop(request.at("name"s).AsString());
 
-	if (!sorted_bus_names) {
+	if (!bus_ids) {
 		return Builder{}.StartDict()
 							.Key("request_id"s).Value(request.at("id"s).AsInt())
 							.Key("error_message"s).Value("not found"s)
@@ -565,9 +799,10 @@ json::Node Stop(const json::Dict& request,
 						.Build();
 	}
 
+	const auto& transport_catalogue = request_handler.GetTransportCatalogue();
 	Array result;
-	for (const auto bus_name : *sorted_bus_names) {
-		result.push_back(Node{std::string(bus_name)});
+	for (const auto bus_id : *bus_ids) {
+		result.push_back(Node{StringRef{serialization::GetName(transport_catalogue, transport_catalogue.bus(bus_id))}});
 	}
 
 	return Builder{}.StartDict()
@@ -597,7 +832,10 @@ json::Node Route(const json::Dict& request,
 	using namespace std::literals;
 	using namespace json;
 
-	const auto& route_info = request_handler.GetRouteInfo(request.at("from"s).AsString(), request.at("to"s).AsString());
+	const bool arrive_by = request.count("arrive_by"s) && request.at("arrive_by"s).AsBool();
+	const auto& route_info = arrive_by
+			? request_handler.GetArriveByRouteInfo(request.at("from"s).AsString(), request.at("to"s).AsString())
+			: request_handler.GetRouteInfo(request.at("from"s).AsString(), request.at("to"s).AsString());
 	if (!route_info) {
 		return Builder{}.StartDict()
 							.Key("request_id"s).Value(request.at("id"s).AsInt())
@@ -619,48 +857,536 @@ json::Node Route(const json::Dict& request,
 					.Build();
 }
 
-}  // namespace make_stat
+json::Node RouterStatus(const json::Dict& request,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+	using namespace json;
 
-void MakeStatAnswer(std::ostream& output, const json::Array& stat_requests,
+	const auto status = request_handler.GetRouterStatus();
+
+	if (!status.is_table_engine) {
+		return Builder{}.StartDict()
+							.Key("engine"s).Value("search"s)
+							.Key("request_id"s).Value(request.at("id"s).AsInt())
+							.Key("state"s).Value("ready"s)
+						.EndDict()
+						.Build();
+	}
+	return Builder{}.StartDict()
+						.Key("engine"s).Value("table"s)
+						.Key("progress"s).Value(status.progress)
+						.Key("request_id"s).Value(request.at("id"s).AsInt())
+						.Key("state"s).Value(status.is_ready ? "ready"s : "building"s)
+					.EndDict()
+					.Build();
+}
+
+json::Node NearestStops(const json::Dict& request,
 		const request_handler::RequestHandlerProto& request_handler) {
 	using namespace std::literals;
 	using namespace json;
 
+	const geo::Coordinates point{request.at("latitude"s).AsDouble(), request.at("longitude"s).AsDouble()};
+	const int count = request.at("count"s).AsInt();
+	const auto& transport_catalogue = request_handler.GetTransportCatalogue();
+
 	Array result;
+	for (const auto& neighbour : request_handler.FindNearestStops(point, count > 0 ? count : 0)) {
+		result.push_back(Builder{}.StartDict()
+								.Key("distance"s).Value(neighbour.distance)
+								.Key("name"s).Value(StringRef{serialization::GetName(transport_catalogue,
+										transport_catalogue.stop(neighbour.id))})
+							.EndDict()
+							.Build());
+	}
+
+	return Builder{}.StartDict()
+						.Key("request_id"s).Value(request.at("id"s).AsInt())
+						.Key("stops"s).Value(std::move(result))
+					.EndDict()
+					.Build();
+}
+
+json::Node StopsInBox(const json::Dict& request,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+	using namespace json;
+
+	const geo::Coordinates min{request.at("min_latitude"s).AsDouble(), request.at("min_longitude"s).AsDouble()};
+	const geo::Coordinates max{request.at("max_latitude"s).AsDouble(), request.at("max_longitude"s).AsDouble()};
+	const auto& transport_catalogue = request_handler.GetTransportCatalogue();
+
+	std::vector<std::string_view> names;
+	for (const auto stop_id : request_handler.FindStopsInBox(min, max)) {
+		names.push_back(serialization::GetName(transport_catalogue, transport_catalogue.stop(stop_id)));
+	}
+	std::sort(names.begin(), names.end());
+
+	Array result;
+	for (const auto name : names) {
+		result.push_back(Node{StringRef{name}});
+	}
+
+	return Builder{}.StartDict()
+						.Key("request_id"s).Value(request.at("id"s).AsInt())
+						.Key("stops"s).Value(std::move(result))
+					.EndDict()
+					.Build();
+}
+
+json::Node SearchStops(const json::Dict& request,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+	using namespace json;
+
+	const size_t DEFAULT_LIMIT = 10;
+
+	const std::string_view query = request.at("query"s).AsString();
+	const size_t limit = request.count("limit"s) ? std::max(0, request.at("limit"s).AsInt()) : DEFAULT_LIMIT;
+	const uint32_t max_errors = request.count("max_errors"s) ? std::max(0, request.at("max_errors"s).AsInt()) : 0;
+	const auto& transport_catalogue = request_handler.GetTransportCatalogue();
+
+	Array result;
+	if (max_errors == 0) {
+		for (const auto stop_id : request_handler.SearchStopsByPrefix(query, limit)) {
+			result.push_back(Node{StringRef{serialization::GetName(transport_catalogue, transport_catalogue.stop(stop_id))}});
+		}
+	} else {
+		for (const auto& match : request_handler.SearchStopsApproximately(query, max_errors, limit)) {
+			result.push_back(Node{StringRef{serialization::GetName(transport_catalogue, transport_catalogue.stop(match.id))}});
+		}
+	}
+
+	return Builder{}.StartDict()
+						.Key("request_id"s).Value(request.at("id"s).AsInt())
+						.Key("stops"s).Value(std::move(result))
+					.EndDict()
+					.Build();
+}
+
+json::Node SegmentDistance(const json::Dict& request,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+	using namespace json;
+
+	const int from = request.at("from"s).AsInt();
+	const int to = request.at("to"s).AsInt();
+	const auto distance = from < 0 || to < 0
+			? std::nullopt
+			: request_handler.GetSegmentDistance(request.at("bus"s).AsString(), from, to);
+	if (!distance) {
+		return Builder{}.StartDict()
+							.Key("request_id"s).Value(request.at("id"s).AsInt())
+							.Key("error_message"s).Value("not found"s)
+						.EndDict()
+						.Build();
+	}
+
+	return Builder{}.StartDict()
+						.Key("geo_distance"s).Value(distance->geo)
+						.Key("request_id"s).Value(request.at("id"s).AsInt())
+						.Key("road_distance"s).Value(static_cast<int64_t>(distance->road))
+					.EndDict()
+					.Build();
+}
+
+json::Node DirectBuses(const json::Dict& request,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+	using namespace json;
+
+	const auto bus_ids = request_handler.FindDirectBuses(request.at("from"s).AsString(), request.at("to"s).AsString());
+	if (!bus_ids) {
+		return Builder{}.StartDict()
+							.Key("request_id"s).Value(request.at("id"s).AsInt())
+							.Key("error_message"s).Value("not found"s)
+						.EndDict()
+						.Build();
+	}
+
+	const auto& transport_catalogue = request_handler.GetTransportCatalogue();
+	Array result;
+	for (const auto bus_id : *bus_ids) {
+		result.push_back(Node{StringRef{serialization::GetName(transport_catalogue, transport_catalogue.bus(bus_id))}});
+	}
+
+	return Builder{}.StartDict()
+						.Key("buses"s).Value(std::move(result))
+						.Key("request_id"s).Value(request.at("id"s).AsInt())
+					.EndDict()
+					.Build();
+}
+
+json::Node Stats(const json::Dict& request,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+	using namespace json;
+
+	const auto to_int64 = [](size_t value) {
+		return static_cast<int64_t>(std::min<size_t>(value, std::numeric_limits<int64_t>::max()));
+	};
+
+	const auto report = request_handler.MemoryUsage();
+	Array structures;
+	for (const auto& item : report.GetItems()) {
+		structures.push_back(Builder{}.StartDict()
+								.Key("allocations"s).Value(to_int64(item.allocations))
+								.Key("bytes"s).Value(to_int64(item.bytes))
+								.Key("capacity"s).Value(to_int64(item.capacity))
+								.Key("name"s).Value(item.name)
+								.Key("size"s).Value(to_int64(item.size))
+							.EndDict()
+							.Build());
+	}
+
+	return Builder{}.StartDict()
+						.Key("request_id"s).Value(request.at("id"s).AsInt())
+						.Key("structures"s).Value(std::move(structures))
+						.Key("total_allocations"s).Value(to_int64(report.TotalAllocations()))
+						.Key("total_bytes"s).Value(to_int64(report.TotalBytes()))
+					.EndDict()
+					.Build();
+}
+
+}  // namespace make_stat
+
+// ответ на один запрос stat_requests; запросы неизвестного типа остаются без ответа
+std::optional<json::Node> MakeStatResponse(const json::Dict& request,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+
+	const std::string_view type = request.at("type"s).AsString();
+	if (type == "Bus"s) {
+		return make_stat::Bus(request, request_handler);
+	} else if (type == "Stop"s) {
+		return make_stat::Stop(request, request_handler);
+	}
+	else if (type == "Map"s) {
+		return make_stat::RenderedMap(request, request_handler);
+	}
+	else if (type == "Route"s) {
+		return make_stat::Route(request, request_handler);
+	}
+	else if (type == "RouterStatus"s) {
+		return make_stat::RouterStatus(request, request_handler);
+	}
+	else if (type == "NearestStops"s) {
+		return make_stat::NearestStops(request, request_handler);
+	}
+	else if (type == "StopsInBox"s) {
+		return make_stat::StopsInBox(request, request_handler);
+	}
+	else if (type == "SearchStops"s) {
+		return make_stat::SearchStops(request, request_handler);
+	}
+	else if (type == "SegmentDistance"s) {
+		return make_stat::SegmentDistance(request, request_handler);
+	}
+	else if (type == "DirectBuses"s) {
+		return make_stat::DirectBuses(request, request_handler);
+	}
+	else if (type == "Stats"s) {
+		return make_stat::Stats(request, request_handler);
+	}
+	return std::nullopt;
+}
+
+// Ответ на запрос, который не удалось выполнить: неверный тип поля, нет обязательного
+// поля и т. п. request_id равен null, если у запроса нет целого id
+json::Node MakeErrorResponse(const json::Node& request, std::string_view message) {
+	using namespace std::literals;
+
+	json::Node::Value request_id = nullptr;
+	if (request.IsDict() && request.AsDict().count("id"s) && request.AsDict().at("id"s).IsInt()) {
+		request_id = request.AsDict().at("id"s).AsInt();
+	}
+	return json::Builder{}.StartDict()
+							.Key("request_id"s).Value(std::move(request_id))
+							.Key("error_message"s).Value(std::string(message))
+						.EndDict()
+						.Build();
+}
+
+// Ответы выводятся по мере разбора, поэтому ошибка в одном запросе не прерывает
+// вывод: вместо ответа на него выводится сообщение об ошибке
+std::optional<json::Node> AnswerStatRequest(const json::Node& request,
+		const request_handler::RequestHandlerProto& request_handler) {
+	try {
+		return MakeStatResponse(request.AsDict(), request_handler);
+	} catch (const std::exception& error) {
+		return MakeErrorResponse(request, error.what());
+	}
+}
+
+void MakeStatAnswer(std::ostream& output, const json::Array& stat_requests,
+		const request_handler::RequestHandlerProto& request_handler) {
+	json::ArrayPrinter printer(output);
 	for (const auto& request : stat_requests) {
-		const std::string& type = request.AsDict().at("type"s).AsString();
-		if (type == "Bus"s) {
-			result.emplace_back(make_stat::Bus(request.AsDict(), request_handler));
-		} else if (type == "Stop"s) {
-			result.emplace_back(make_stat::Stop(request.AsDict(), request_handler));
+		if (auto response = AnswerStatRequest(request, request_handler)) {
+			printer.Add(*response);
 		}
-		else if (type == "Map"s) {
-			result.emplace_back(make_stat::RenderedMap(request.AsDict(), request_handler));
+	}
+	printer.Finish();
+}
+
+class DeserializeError : public std::runtime_error {
+public:
+	using runtime_error::runtime_error;
+};
+
+// загружает базу из файла serialization_settings и готовит индексы для stat_requests
+void LoadDataBase(const json::Dict& serialization_settings, transport_catalogue_proto::DataBase& db,
+		renderer::MapRenderer& map_renderer, request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+
+	const std::string file_name(serialization_settings.at("file"s).AsString());
+	std::ifstream file(file_name, std::ios::binary);
+	if (!db.ParseFromIstream(&file)) {
+		throw DeserializeError("Deserialize failed"s);
+	}
+
+	request_handler.FillStopIndex();
+	request_handler.FillStopNameIndex();
+	fill::MapRenderer(map_renderer,  db.map_renderer(), db.transport_catalogue());
+	fill::Router(request_handler);
+}
+
+// Входные данные process_requests. Разделы верхнего уровня собираются в дерево по одному.
+// Когда база уже загружена, запросы stat_requests выполняются и выводятся по мере разбора:
+// в памяти находится только текущий запрос и ответ на него. Запросы, встретившиеся
+// до serialization_settings, откладываются до конца разбора
+class ProcessRequestsHandler final : public json::Handler {
+public:
+	ProcessRequestsHandler(std::ostream& output, transport_catalogue_proto::DataBase& db,
+			renderer::MapRenderer& map_renderer, request_handler::RequestHandlerProto& request_handler)
+		: output_(output)
+		, db_(db)
+		, map_renderer_(map_renderer)
+		, request_handler_(request_handler) {
+	}
+
+	void Null() override {
+		Target().Null();
+		FinishValue();
+	}
+
+	void Bool(bool value) override {
+		Target().Bool(value);
+		FinishValue();
+	}
+
+	void Int(int value) override {
+		Target().Int(value);
+		FinishValue();
+	}
+
+	void Int64(int64_t value) override {
+		Target().Int64(value);
+		FinishValue();
+	}
+
+	void Double(double value) override {
+		Target().Double(value);
+		FinishValue();
+	}
+
+	void String(std::string_view value, bool copy) override {
+		Target().String(value, copy);
+		FinishValue();
+	}
+
+	void StartArray() override {
+		if (depth_ == 1 && streaming_) {
+			printer_.emplace(output_);
+		} else {
+			Target().StartArray();
 		}
-		else if (type == "Route"s) {
-			result.emplace_back(make_stat::Route(request.AsDict(), request_handler));
+		++depth_;
+	}
+
+	void EndArray() override {
+		--depth_;
+		if (depth_ == 1 && streaming_) {
+			printer_->Finish();
+			printer_.reset();
+			streaming_ = false;
+			return;
 		}
+		builder_.EndArray();
+		FinishValue();
 	}
-	Print(Document{Builder{}.Value(std::move(result)).Build()}, output);
+
+	void StartDict() override {
+		if (depth_ > 0) {
+			builder_.StartDict();
+		}
+		++depth_;
+	}
+
+	void Key(std::string_view key, bool copy) override {
+		using namespace std::literals;
+		if (depth_ == 1) {
+			section_.assign(key);
+			streaming_ = loaded_ && section_ == "stat_requests"sv;
+			return;
+		}
+		builder_.Key(key, copy);
+	}
+
+	void EndDict() override {
+		--depth_;
+		if (depth_ == 0) {
+			return;
+		}
+		builder_.EndDict();
+		FinishValue();
+	}
+
+	// запросы stat_requests, встретившиеся до загрузки базы
+	const std::optional<json::Node>& GetPendingRequests() const {
+		return pending_requests_;
+	}
+
+	// Закрывает начатый массив ответов, если разбор прервался ошибкой:
+	// уже выведенные ответы остаются корректным JSON
+	void FinishOutput() {
+		if (printer_) {
+			printer_->Finish();
+			printer_.reset();
+			// исключение может завершить программу без сброса буферов вывода
+			output_.flush();
+		}
+		streaming_ = false;
+	}
+
+private:
+	std::ostream& output_;
+	transport_catalogue_proto::DataBase& db_;
+	renderer::MapRenderer& map_renderer_;
+	request_handler::RequestHandlerProto& request_handler_;
+
+	json::TreeBuilder builder_;
+	std::optional<json::ArrayPrinter> printer_;
+	std::optional<json::Node> pending_requests_;
+	std::string section_; // раздел верхнего уровня, который сейчас разбирается
+	int depth_ = 0;
+	bool loaded_ = false;
+	bool streaming_ = false;
+
+	json::Handler& Target() {
+		using namespace std::literals;
+		if (depth_ == 0) {
+			throw std::logic_error("Not a dict"s);
+		}
+		return builder_;
+	}
+
+	// значение раздела либо запрос stat_requests разобраны целиком
+	void FinishValue() {
+		using namespace std::literals;
+		if (depth_ == 2 && streaming_) {
+			if (auto response = AnswerStatRequest(builder_.Extract(), request_handler_)) {
+				printer_->Add(*response);
+			}
+		} else if (depth_ == 1) {
+			json::Node value = builder_.Extract();
+			if (section_ == "serialization_settings"sv) {
+				LoadDataBase(value.AsDict(), db_, map_renderer_, request_handler_);
+				loaded_ = true;
+			} else if (section_ == "stat_requests"sv) {
+				pending_requests_ = std::move(value);
+			}
+			streaming_ = false;
+		}
+	}
+};
+
+namespace travel_times {
+
+void PrintCsvField(std::string_view field, std::ostream& output) {
+	if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+		output << field;
+		return;
+	}
+	output.put('"');
+	for (const char c : field) {
+		if (c == '"') {
+			output.put('"');
+		}
+		output.put(c);
+	}
+	output.put('"');
 }
 
+std::vector<uint64_t> ParseOrigins(const json::Dict& settings,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+
+	const auto& stops = request_handler.GetTransportCatalogue().stop();
+	std::vector<uint64_t> result;
+	if (!settings.count("origins"s)) {
+		for (const auto& stop : stops) {
+			result.push_back(stop.id());
+		}
+		return result;
+	}
+	for (const auto& stop_name : settings.at("origins"s).AsArray()) {
+		const auto stop = request_handler.FindStop(stop_name.AsString());
+		if (!stop) {
+			throw std::invalid_argument("Unknown stop "s + std::string(stop_name.AsString()));
+		}
+		result.push_back(stop->id());
+	}
+	return result;
+}
+
+void MakeMatrix(std::ostream& output, const std::vector<uint64_t>& origins,
+		const request_handler::RequestHandlerProto& request_handler) {
+	using namespace std::literals;
+
+	const auto& catalogue = request_handler.GetTransportCatalogue();
+
+	output << "from"sv;
+	for (const auto& stop : catalogue.stop()) {
+		output.put(',');
+		PrintCsvField(serialization::GetName(catalogue, stop), output);
+	}
+	output.put('\n');
+
+	request_handler.ComputeTravelTimes(origins,
+			[&output, &catalogue](uint64_t stop_id, const std::vector<transport_router::Minutes>& row) {
+				PrintCsvField(serialization::GetName(catalogue, catalogue.stop(stop_id)), output);
+				for (const auto time : row) {
+					output.put(',');
+					if (std::isfinite(time)) {
+						output << time;
+					}
+				}
+				output.put('\n');
+			});
+}
+
+}  // namespace travel_times
+
 }  // namespace proto
 
-void MakeBase(std::istream& input) {
+void MakeBase(std::shared_ptr<const json::InputBuffer> input, std::ostream* memory_report) {
 	using namespace std::literals;
 
 	TransportCatalogue transport_catalogue;
 	transport_router::TransportRouter transport_router;
 
-	const json::Document& doc = json::Load(input);
-	const auto& commands = doc.GetRoot().AsDict();
+	defaulted::request_parser::MakeBaseHandler handler;
+	json::Parse(input->GetData(), handler);
+	const json::Node root = handler.ExtractCommands();
+	const auto& commands = root.AsDict();
 	serialization::DataBaseSerializer db;
 
-	if (commands.count("base_requests"s)) {
-		defaulted::fill::TransportCatalogue(commands.at("base_requests"s).AsArray(), transport_catalogue);
+	if (handler.HasBaseRequests()) {
+		transport_catalogue.Load(handler.ExtractCatalogueData());
 	}
 	if (commands.count("serialization_settings"s)) {
-		const std::string& file_name = commands.at("serialization_settings"s).AsDict().at("file"s).AsString();
+		const std::string file_name(commands.at("serialization_settings"s).AsDict().at("file"s).AsString());
 		db.SetFileName(file_name);
 		db.SetTransportCatalogue(transport_catalogue);
 	}
@@ -673,35 +1399,72 @@ void MakeBase(std::istream& input) {
 				defaulted::request_parser::ParseRoutingSettings(
 						commands.at("routing_settings"s).AsDict())));
 		transport_router.BuildRouter(transport_catalogue);
-		db.SetTransportRouter(transport_router, transport_catalogue);
+		db.SetTransportRouter(transport_router);
 	}
 
 	db.Serialize();
+
+	if (memory_report) {
+		memory_usage::Report report;
+		report.Append("transport_catalogue", transport_catalogue.MemoryUsage());
+		report.Append("transport_router", transport_router.MemoryUsage());
+		report.Print(*memory_report);
+	}
 }
 
-void ProcessRequests(std::istream& input, std::ostream& output) {
+void ProcessRequests(std::shared_ptr<const json::InputBuffer> input, std::ostream& output,
+		std::ostream* memory_report) {
+	transport_catalogue_proto::DataBase db;
+	renderer::MapRenderer map_renderer;
+	request_handler::RequestHandlerProto request_handler(db, map_renderer);
+
+	proto::ProcessRequestsHandler handler(output, db, map_renderer, request_handler);
+	try {
+		json::Parse(input->GetData(), handler);
+	} catch (const proto::DeserializeError& error) {
+		std::cerr << error.what() << std::endl;
+		return;
+	} catch (...) {
+		handler.FinishOutput();
+		throw;
+	}
+	if (const auto& stat_requests = handler.GetPendingRequests()) {
+		proto::MakeStatAnswer(output, stat_requests->AsArray(), request_handler);
+	}
+	if (memory_report) {
+		request_handler.MemoryUsage().Print(*memory_report);
+	}
+}
+
+void TravelTimes(const json::Document& doc, std::ostream& output, std::ostream* memory_report) {
 	using namespace std::literals;
 
 	transport_catalogue_proto::DataBase db;
 	renderer::MapRenderer map_renderer;
 	request_handler::RequestHandlerProto request_handler(db, map_renderer);
 
-	const json::Document& doc = json::Load(input);
 	const auto& commands = doc.GetRoot().AsDict();
-	if (commands.count("serialization_settings"s)) {
-		const auto& file_name = commands.at("serialization_settings"s).AsDict().at("file"s).AsString();
-		std::ifstream file(file_name, std::ios::binary);
-		if (!db.ParseFromIstream(&file)) {
-			std::cerr << "Deserialize failed" << std::endl;
-//			assert(false);
-			return;
-		}
-
-		proto::fill::MapRenderer(map_renderer,  db.map_renderer(), db.transport_catalogue());
-		proto::fill::Router(request_handler);
+	if (!commands.count("serialization_settings"s)) {
+		return;
 	}
-	if (commands.count("stat_requests"s)) {
-		proto::MakeStatAnswer(output, commands.at("stat_requests"s).AsArray(), request_handler);
+	const std::string file_name(commands.at("serialization_settings"s).AsDict().at("file"s).AsString());
+	std::ifstream file(file_name, std::ios::binary);
+	if (!db.ParseFromIstream(&file)) {
+		std::cerr << "Deserialize failed" << std::endl;
+		return;
+	}
+
+	request_handler.FillStopNameIndex();
+	request_handler.FillGraph();
+	request_handler.FillContractionHierarchy();
+
+	const json::Dict no_settings;
+	const auto& settings = commands.count("travel_times"s)
+			? commands.at("travel_times"s).AsDict()
+			: no_settings;
+	proto::travel_times::MakeMatrix(output, proto::travel_times::ParseOrigins(settings, request_handler), request_handler);
+	if (memory_report) {
+		request_handler.MemoryUsage().Print(*memory_report);
 	}
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 
 #include "json.h"
 #include "map_renderer.h"
@@ -10,8 +11,20 @@
 
 namespace transport_catalogue::json_reader {
 
-void MakeBase(std::istream& input);
+// Если задан memory_report, в него выводится отчёт о памяти построенных структур
+// base_requests разбираются потоково, без дерева узлов; названия ссылаются на input
+void MakeBase(std::shared_ptr<const json::InputBuffer> input, std::ostream* memory_report = nullptr);
 
-void ProcessRequests(std::istream& input, std::ostream& output);
+// Запросы stat_requests, идущие после serialization_settings, выполняются и выводятся
+// по мере разбора input, без сборки всего документа и всех ответов. Запрос, который
+// не удалось выполнить, получает ответ с error_message. Если input оборвался или
+// содержит ошибку разбора, массив уже выведенных ответов закрывается и исключение
+// передаётся дальше
+void ProcessRequests(std::shared_ptr<const json::InputBuffer> input, std::ostream& output,
+		std::ostream* memory_report = nullptr);
+
+// Выводит в output CSV-матрицу времени в пути от остановок travel_times.origins
+// (по умолчанию от всех) до всех остановок справочника
+void TravelTimes(const json::Document& doc, std::ostream& output, std::ostream* memory_report = nullptr);
 
 }  // namespace transport_catalogue::json_reader
@@ -11,29 +11,48 @@
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-	stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+	stream << "Usage: transport_catalogue [make_base|process_requests|travel_times] [--memory-report]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
 	using namespace transport_catalogue;
 
-	if (argc != 2) {
+	if (argc != 2 && argc != 3) {
 		PrintUsage();
 		return 1;
 	}
 
 	const std::string_view mode(argv[1]);
 
+	// отчёт о памяти выводится в stderr, чтобы не смешиваться с ответами
+	std::ostream* memory_report = nullptr;
+	if (argc == 3) {
+		if (std::string_view(argv[2]) != "--memory-report"sv) {
+			PrintUsage();
+			return 1;
+		}
+		memory_report = &std::cerr;
+	}
+
+	if (mode != "make_base"sv && mode != "process_requests"sv && mode != "travel_times"sv) {
+		PrintUsage();
+		return 1;
+	}
+
+	// входные данные читаются целиком; строки документа ссылаются на этот буфер
+	const auto input = json::InputBuffer::FromStdin();
+
 	if (mode == "make_base"sv) {
 
-		json_reader::MakeBase(std::cin);
+		json_reader::MakeBase(input, memory_report);
 
 	} else if (mode == "process_requests"sv) {
 
-		json_reader::ProcessRequests(std::cin, std::cout);
+		json_reader::ProcessRequests(input, std::cout, memory_report);
 
 	} else {
-		PrintUsage();
-		return 1;
+
+		json_reader::TravelTimes(json::Load(input), std::cout, memory_report);
+
 	}
 }
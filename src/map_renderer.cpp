@@ -1,11 +1,12 @@
 #include "map_renderer.h"
+#include "serialization.h"
 
 namespace transport_catalogue::renderer {
 
 namespace detail {
 
 std::deque<geo::Coordinates>
-MakeStopCoordinatesDeque(const std::deque<domain::StopPtr>& stops) {
+MakeStopCoordinatesDeque(const std::vector<domain::StopPtr>& stops) {
 	std::deque<geo::Coordinates> result;
 	for (const auto& stop : stops) {
 		result.push_back(stop->coordinates);
@@ -39,7 +40,7 @@ void MapRenderer::SetRenderSettings(RenderSettings settings) {
 	settings_ = std::move(settings);
 }
 
-void MapRenderer::RenderMap(const std::deque<domain::BusPtr>& buses, const std::deque<domain::StopPtr>& stops) {
+void MapRenderer::RenderMap(const std::vector<domain::BusPtr>& buses, const std::vector<domain::StopPtr>& stops) {
 	const auto& stop_coordinates = detail::MakeStopCoordinatesDeque(stops);
 	SphereProjector sphere_projector(stop_coordinates.begin(), stop_coordinates.end(),
 			settings_.width, settings_.height, settings_.padding);
@@ -54,8 +55,21 @@ const svg::Document& MapRenderer::GetRenderedMap() const {
 	return map_;
 }
 
+memory_usage::Report MapRenderer::MemoryUsage() const {
+	memory_usage::Report report;
+	memory_usage::Item palette = memory_usage::OfVector("color_palette", settings_.color_palette);
+	for (const auto& color : settings_.color_palette) {
+		if (std::holds_alternative<std::string>(color)) {
+			memory_usage::AddString(palette, std::get<std::string>(color));
+		}
+	}
+	report.Add(std::move(palette));
+	report.Add(map_.MemoryUsage());
+	return report;
+}
+
 // добавляет линии автобусных маршрутов
-void MapRenderer::AddBusLines(const std::deque<domain::BusPtr>& buses,
+void MapRenderer::AddBusLines(const std::vector<domain::BusPtr>& buses,
 		const SphereProjector& sphere_projector) {
 	size_t non_empty_bus_counter = 0;
 	size_t color_pallete_size = settings_.color_palette.size();
@@ -86,7 +100,7 @@ void MapRenderer::AddBusLines(const std::deque<domain::BusPtr>& buses,
 	}
 }
 
-svg::Text MapRenderer::MakeBusUnderlayerText(const std::string& bus_name,
+svg::Text MapRenderer::MakeBusUnderlayerText(std::string_view bus_name,
 		svg::Point stop_coordinates) {
 	using namespace std::literals;
 
@@ -101,12 +115,12 @@ svg::Text MapRenderer::MakeBusUnderlayerText(const std::string& bus_name,
 			.SetFontSize(settings_.bus_label_font_size)
 			.SetFontFamily("Verdana"s)
 			.SetFontWeight("bold"s)
-			.SetData(bus_name);
+			.SetData(std::string(bus_name));
 
 	return underlayer;
 }
 
-svg::Text MapRenderer::MakeBusLabelText(const std::string& bus_name,
+svg::Text MapRenderer::MakeBusLabelText(std::string_view bus_name,
 		svg::Point stop_coordinates, const size_t palette_index) {
 	using namespace std::literals;
 
@@ -117,13 +131,13 @@ svg::Text MapRenderer::MakeBusLabelText(const std::string& bus_name,
 			.SetFontSize(settings_.bus_label_font_size)
 			.SetFontFamily("Verdana"s)
 			.SetFontWeight("bold"s)
-			.SetData(bus_name);
+			.SetData(std::string(bus_name));
 
 	return bus_label;
 }
 
 // добавляет названия автобусных маршрутов
-void MapRenderer::AddBusNames(const std::deque<domain::BusPtr>& buses,
+void MapRenderer::AddBusNames(const std::vector<domain::BusPtr>& buses,
 		const SphereProjector& sphere_projector) {
 	size_t non_empty_bus_counter = 0;
 	size_t color_pallete_size = settings_.color_palette.size();
@@ -152,14 +166,14 @@ svg::Circle MapRenderer::MakeStopCircle(svg::Point stop_coordinates) {
 	return stop_circle;
 }
 
-void MapRenderer::AddStopCircles(const std::deque<domain::StopPtr>& stops,
+void MapRenderer::AddStopCircles(const std::vector<domain::StopPtr>& stops,
 		const SphereProjector& sphere_projector) {
 	for (const auto& stop : stops) {
 		map_.Add(MakeStopCircle(sphere_projector(stop->coordinates)));
 	}
 }
 
-svg::Text MapRenderer::MakeStopUnderlayerText(const std::string& stop_name,
+svg::Text MapRenderer::MakeStopUnderlayerText(std::string_view stop_name,
 		svg::Point stop_coordinates) {
 	using namespace std::literals;
 
@@ -173,12 +187,12 @@ svg::Text MapRenderer::MakeStopUnderlayerText(const std::string& stop_name,
 			.SetOffset(settings_.stop_label_offset)
 			.SetFontSize(settings_.stop_label_font_size)
 			.SetFontFamily("Verdana"s)
-			.SetData(stop_name);
+			.SetData(std::string(stop_name));
 
 	return underlayer;
 }
 
-svg::Text MapRenderer::MakeStopLabelText(const std::string& stop_name,
+svg::Text MapRenderer::MakeStopLabelText(std::string_view stop_name,
 		svg::Point stop_coordinates) {
 	using namespace std::literals;
 
@@ -188,12 +202,12 @@ svg::Text MapRenderer::MakeStopLabelText(const std::string& stop_name,
 			.SetOffset(settings_.stop_label_offset)
 			.SetFontSize(settings_.stop_label_font_size)
 			.SetFontFamily("Verdana"s)
-			.SetData(stop_name);
+			.SetData(std::string(stop_name));
 
 	return bus_label;
 }
 
-void MapRenderer::AddStopNames(const std::deque<domain::StopPtr>& stops,
+void MapRenderer::AddStopNames(const std::vector<domain::StopPtr>& stops,
 		const SphereProjector& sphere_projector) {
 	for (const auto& stop : stops) {
 		map_.Add(MakeStopUnderlayerText(stop->name, sphere_projector(stop->coordinates)));
@@ -247,13 +261,14 @@ void MapRenderer::AddBusNames(const map_renderer_proto::MapRenderer& map_rendere
 		}
 		const size_t palette_index = non_empty_bus_counter++ % color_pallete_size;
 		const auto& bus = transport_catalogue.bus(polyline.bus_id());
+		const std::string_view bus_name = serialization::GetName(transport_catalogue, bus);
 
-		map_.Add(MakeBusUnderlayerText(bus.name(), detail::LoadPoint(polyline.point(0))));
-		map_.Add(MakeBusLabelText(bus.name(), detail::LoadPoint(polyline.point(0)), palette_index));
+		map_.Add(MakeBusUnderlayerText(bus_name, detail::LoadPoint(polyline.point(0))));
+		map_.Add(MakeBusLabelText(bus_name, detail::LoadPoint(polyline.point(0)), palette_index));
 
 		if (!bus.is_circle() && size != 1) {
-			map_.Add(MakeBusUnderlayerText(bus.name(), detail::LoadPoint(polyline.point(size - 1u))));
-			map_.Add(MakeBusLabelText(bus.name(), detail::LoadPoint(polyline.point(size - 1u)), palette_index));
+			map_.Add(MakeBusUnderlayerText(bus_name, detail::LoadPoint(polyline.point(size - 1u))));
+			map_.Add(MakeBusLabelText(bus_name, detail::LoadPoint(polyline.point(size - 1u)), palette_index));
 		}
 	}
 }
@@ -268,7 +283,8 @@ void MapRenderer::AddStopCircles(const map_renderer_proto::MapRenderer& map_rend
 void MapRenderer::AddStopNames(const map_renderer_proto::MapRenderer& map_renderer,
 		const transport_catalogue_proto::TransportCatalogue& transport_catalogue) {
 	for (const auto& circle : map_renderer.circle()) {
-		const std::string& stop_name = transport_catalogue.stop(circle.stop_id()).name();
+		const std::string_view stop_name = serialization::GetName(transport_catalogue,
+				transport_catalogue.stop(circle.stop_id()));
 		map_.Add(MakeStopUnderlayerText(stop_name, detail::LoadPoint(circle.pos())));
 		map_.Add(MakeStopLabelText(stop_name, detail::LoadPoint(circle.pos())));
 	}
@@ -19,7 +19,7 @@ namespace transport_catalogue::renderer {
 
 namespace detail {
 
-std::deque<geo::Coordinates> MakeStopCoordinatesDeque(const std::deque<domain::StopPtr>& stops);
+std::deque<geo::Coordinates> MakeStopCoordinatesDeque(const std::vector<domain::StopPtr>& stops);
 
 svg::Point LoadPoint(const svg_proto::Point& p);
 
@@ -103,35 +103,37 @@ public:
 
 	void SetRenderSettings(RenderSettings settings);
 
-	void RenderMap(const std::deque<domain::BusPtr>& buses, const std::deque<domain::StopPtr>& stops);
+	void RenderMap(const std::vector<domain::BusPtr>& buses, const std::vector<domain::StopPtr>& stops);
 
 	void RenderMap(const map_renderer_proto::MapRenderer& map_renderer,
 			const transport_catalogue_proto::TransportCatalogue& transport_catalogue);
 
 	const svg::Document& GetRenderedMap() const;
 
+	memory_usage::Report MemoryUsage() const;
+
 private:
 	RenderSettings settings_;
 	svg::Document map_;
 
 private:
-	void AddBusLines(const std::deque<domain::BusPtr>& buses, const SphereProjector& sphere_projector);
+	void AddBusLines(const std::vector<domain::BusPtr>& buses, const SphereProjector& sphere_projector);
 
-	svg::Text MakeBusUnderlayerText(const std::string& bus_name, svg::Point stop_coordinates);
+	svg::Text MakeBusUnderlayerText(std::string_view bus_name, svg::Point stop_coordinates);
 
-	svg::Text MakeBusLabelText(const std::string& bus_name, svg::Point stop_coordinates, const size_t palette_index);
+	svg::Text MakeBusLabelText(std::string_view bus_name, svg::Point stop_coordinates, const size_t palette_index);
 
-	void AddBusNames(const std::deque<domain::BusPtr>& buses, const SphereProjector& sphere_projector);
+	void AddBusNames(const std::vector<domain::BusPtr>& buses, const SphereProjector& sphere_projector);
 
 	svg::Circle MakeStopCircle(svg::Point stop_coordinates);
 
-	void AddStopCircles(const std::deque<domain::StopPtr>& stops, const SphereProjector& sphere_projector);
+	void AddStopCircles(const std::vector<domain::StopPtr>& stops, const SphereProjector& sphere_projector);
 
-	svg::Text MakeStopUnderlayerText(const std::string& stop_name, svg::Point stop_coordinates);
+	svg::Text MakeStopUnderlayerText(std::string_view stop_name, svg::Point stop_coordinates);
 
-	svg::Text MakeStopLabelText(const std::string& stop_name, svg::Point stop_coordinates);
+	svg::Text MakeStopLabelText(std::string_view stop_name, svg::Point stop_coordinates);
 
-	void AddStopNames(const std::deque<domain::StopPtr>& stops, const SphereProjector& sphere_projector);
+	void AddStopNames(const std::vector<domain::StopPtr>& stops, const SphereProjector& sphere_projector);
 
 private:
 	void AddBusLines(const map_renderer_proto::MapRenderer& map_renderer,
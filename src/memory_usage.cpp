@@ -0,0 +1,68 @@
+#include "memory_usage.h"
+
+#include <iomanip>
+
+namespace memory_usage {
+
+void Report::Add(Item item) {
+	items_.push_back(std::move(item));
+}
+
+void Report::Append(std::string_view prefix, const Report& other) {
+	for (const auto& item : other.items_) {
+		Item prefixed = item;
+		prefixed.name = std::string(prefix) + "." + item.name;
+		items_.push_back(std::move(prefixed));
+	}
+}
+
+const std::vector<Item>& Report::GetItems() const {
+	return items_;
+}
+
+size_t Report::TotalBytes() const {
+	size_t result = 0;
+	for (const auto& item : items_) {
+		result += item.bytes;
+	}
+	return result;
+}
+
+size_t Report::TotalAllocations() const {
+	size_t result = 0;
+	for (const auto& item : items_) {
+		result += item.allocations;
+	}
+	return result;
+}
+
+void Report::Print(std::ostream& output) const {
+	size_t name_width = 5;
+	for (const auto& item : items_) {
+		name_width = std::max(name_width, item.name.size());
+	}
+
+	output << std::left << std::setw(name_width) << "total" << std::right
+			<< std::setw(14) << TotalBytes() << " B"
+			<< std::setw(10) << TotalAllocations() << " allocs\n";
+	for (const auto& item : items_) {
+		output << std::left << std::setw(name_width) << item.name << std::right
+				<< std::setw(14) << item.bytes << " B"
+				<< std::setw(10) << item.allocations << " allocs"
+				<< std::setw(12) << item.size << " / " << item.capacity << '\n';
+	}
+}
+
+size_t StringHeapBytes(const std::string& str) {
+	// ёмкость строки без выделения памяти равна размеру внутреннего буфера
+	const size_t inline_capacity = std::string().capacity();
+	return str.capacity() > inline_capacity ? str.capacity() + 1 : 0;
+}
+
+void AddString(Item& item, const std::string& str) {
+	const size_t bytes = StringHeapBytes(str);
+	item.bytes += bytes;
+	item.allocations += bytes > 0 ? 1 : 0;
+}
+
+}  // namespace memory_usage
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace memory_usage {
+
+// Память, которую занимает одна структура данных. Размеры узлов и блоков
+// стандартных контейнеров оцениваются по устройству libstdc++
+struct Item {
+	std::string name;
+	size_t bytes = 0; // выделено в куче, включая неиспользуемую ёмкость
+	size_t allocations = 0; // количество выделенных блоков памяти
+	size_t size = 0; // элементов хранится
+	size_t capacity = 0; // элементов помещается без перераспределения
+};
+
+// Отчёт о памяти компонента: по строке на структуру данных
+class Report {
+public:
+	void Add(Item item);
+
+	// добавляет строки other, дописав к их названиям префикс prefix
+	void Append(std::string_view prefix, const Report& other);
+
+	const std::vector<Item>& GetItems() const;
+
+	size_t TotalBytes() const;
+
+	size_t TotalAllocations() const;
+
+	// выводит отчёт таблицей: название, байты, выделения, размер / ёмкость
+	void Print(std::ostream& output) const;
+
+private:
+	std::vector<Item> items_;
+};
+
+// байты строки в куче; короткие строки хранятся внутри объекта
+size_t StringHeapBytes(const std::string& str);
+
+// добавляет к item память, выделенную строкой str
+void AddString(Item& item, const std::string& str);
+
+template <typename T>
+Item OfVector(std::string name, const std::vector<T>& container) {
+	return {std::move(name), container.capacity() * sizeof(T),
+			container.capacity() > 0 ? 1u : 0u, container.size(), container.capacity()};
+}
+
+// вектор векторов: внешний блок и блоки всех вложенных векторов
+template <typename T>
+Item OfNestedVector(std::string name, const std::vector<std::vector<T>>& container) {
+	Item item = OfVector(std::move(name), container);
+	for (const auto& inner : container) {
+		item.bytes += inner.capacity() * sizeof(T);
+		item.allocations += inner.capacity() > 0 ? 1 : 0;
+	}
+	return item;
+}
+
+// дек выделяет блоки по 512 байт (или по одному элементу для крупных элементов)
+// и массив указателей на блоки
+template <typename T>
+Item OfDeque(std::string name, const std::deque<T>& container) {
+	const size_t block_elements = sizeof(T) < 512 ? 512 / sizeof(T) : 1;
+	const size_t blocks = container.size() / block_elements + 1;
+	const size_t map_size = std::max<size_t>(8, blocks + 2);
+	return {std::move(name), blocks * block_elements * sizeof(T) + map_size * sizeof(void*),
+			blocks + 1, container.size(), blocks * block_elements};
+}
+
+// unordered_map и unordered_set: массив корзин и по узлу на элемент
+// (указатель на следующий узел, значение и сохранённый хеш)
+template <typename HashContainer>
+Item OfHashContainer(std::string name, const HashContainer& container) {
+	const size_t node_bytes = sizeof(void*) + sizeof(typename HashContainer::value_type) + sizeof(size_t);
+	return {std::move(name), container.bucket_count() * sizeof(void*) + container.size() * node_bytes,
+			container.size() + 1, container.size(), container.bucket_count()};
+}
+
+}  // namespace memory_usage
@@ -0,0 +1,53 @@
+#include "name_arena.h"
+
+#include <algorithm>
+
+namespace transport_catalogue {
+
+std::string_view NameArena::Intern(std::string_view name) {
+	if (const auto iter = names_.find(name); iter != names_.end()) {
+		return *iter;
+	}
+	const std::string_view stored = Store(name);
+	names_.insert(stored);
+	return stored;
+}
+
+size_t NameArena::NamesAmount() const {
+	return names_.size();
+}
+
+size_t NameArena::BytesUsed() const {
+	return bytes_used_;
+}
+
+memory_usage::Report NameArena::MemoryUsage() const {
+	memory_usage::Report report;
+	// размер и ёмкость блоков — в символах
+	memory_usage::Item blocks = memory_usage::OfDeque("blocks", blocks_);
+	blocks.size = 0;
+	blocks.capacity = 0;
+	for (const auto& block : blocks_) {
+		memory_usage::AddString(blocks, block);
+		blocks.size += block.size();
+		blocks.capacity += block.capacity();
+	}
+	report.Add(std::move(blocks));
+	report.Add(memory_usage::OfHashContainer("names", names_));
+	return report;
+}
+
+std::string_view NameArena::Store(std::string_view name) {
+	if (blocks_.empty() || blocks_.back().capacity() - blocks_.back().size() < name.size()) {
+		blocks_.emplace_back();
+		// длинное название получает собственный блок
+		blocks_.back().reserve(std::max(BLOCK_SIZE, name.size()));
+	}
+	auto& block = blocks_.back();
+	const size_t offset = block.size();
+	block.append(name);
+	bytes_used_ += name.size();
+	return std::string_view(block.data() + offset, name.size());
+}
+
+}  // namespace transport_catalogue
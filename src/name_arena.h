@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+#include "memory_usage.h"
+
+namespace transport_catalogue {
+
+// Хранилище названий остановок и маршрутов. Символы всех названий лежат подряд
+// в крупных блоках, которые никогда не перераспределяются, поэтому выданные
+// string_view остаются действительными всё время жизни хранилища.
+// Одинаковые названия хранятся один раз.
+class NameArena {
+public:
+	NameArena() = default;
+	// выданные string_view ссылаются на блоки хранилища
+	NameArena(const NameArena&) = delete;
+	NameArena& operator=(const NameArena&) = delete;
+
+	// возвращает название из хранилища, при необходимости добавив его
+	std::string_view Intern(std::string_view name);
+
+	size_t NamesAmount() const;
+
+	// суммарный размер названий в байтах
+	size_t BytesUsed() const;
+
+	memory_usage::Report MemoryUsage() const;
+
+private:
+	static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+	std::deque<std::string> blocks_; // ёмкость блока задаётся при создании и не меняется
+	std::unordered_set<std::string_view> names_;
+	size_t bytes_used_ = 0;
+
+	std::string_view Store(std::string_view name);
+};
+
+}  // namespace transport_catalogue
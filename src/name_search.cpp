@@ -0,0 +1,139 @@
+#include "name_search.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace transport_catalogue {
+
+namespace {
+
+bool StartsWith(std::string_view name, std::string_view prefix) {
+	return name.substr(0, prefix.size()) == prefix;
+}
+
+}  // namespace
+
+NameSearchIndex::NameSearchIndex(const std::vector<std::string_view>& names, std::vector<uint32_t> order)
+	: order_(std::move(order)) {
+	if (order_.size() != names.size()) {
+		throw std::invalid_argument("Name order does not match names");
+	}
+	sorted_names_.reserve(order_.size());
+	for (const auto id : order_) {
+		sorted_names_.push_back(names.at(id));
+	}
+}
+
+std::vector<uint32_t> NameSearchIndex::MakeOrder(const std::vector<std::string_view>& names) {
+	std::vector<uint32_t> order(names.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&names](uint32_t lhs, uint32_t rhs) {
+		return names[lhs] < names[rhs] || (names[lhs] == names[rhs] && lhs < rhs);
+	});
+	return order;
+}
+
+const std::vector<uint32_t>& NameSearchIndex::GetOrder() const {
+	return order_;
+}
+
+std::optional<uint32_t> NameSearchIndex::Find(std::string_view name) const {
+	const auto iter = std::lower_bound(sorted_names_.begin(), sorted_names_.end(), name);
+	if (iter == sorted_names_.end() || *iter != name) {
+		return std::nullopt;
+	}
+	return order_[iter - sorted_names_.begin()];
+}
+
+std::vector<uint32_t> NameSearchIndex::FindByPrefix(std::string_view prefix, size_t limit) const {
+	std::vector<uint32_t> result;
+	auto pos = static_cast<size_t>(
+			std::lower_bound(sorted_names_.begin(), sorted_names_.end(), prefix) - sorted_names_.begin());
+	for (; pos < sorted_names_.size() && result.size() < limit && StartsWith(sorted_names_[pos], prefix); ++pos) {
+		result.push_back(order_[pos]);
+	}
+	return result;
+}
+
+size_t NameSearchIndex::SkipPrefix(size_t from, std::string_view prefix) const {
+	return static_cast<size_t>(std::partition_point(sorted_names_.begin() + from, sorted_names_.end(),
+			[prefix](std::string_view name) {
+				return StartsWith(name, prefix);
+			}) - sorted_names_.begin());
+}
+
+std::vector<NameSearchIndex::Match>
+NameSearchIndex::FindApproximate(std::string_view query, uint32_t max_errors, size_t limit) const {
+	std::vector<Match> result;
+	if (!limit) {
+		return result;
+	}
+	const size_t columns = query.size() + 1;
+	// rows[depth][j] — расстояние между первыми depth символами названия и первыми j символами query;
+	// строки переиспользуются для общего префикса соседних названий
+	std::vector<std::vector<uint32_t>> rows(1, std::vector<uint32_t>(columns));
+	std::iota(rows[0].begin(), rows[0].end(), 0);
+	// best[depth] — наименьшее rows[d][query.size()] по d <= depth
+	std::vector<uint32_t> best(1, rows[0][query.size()]);
+
+	std::string_view previous;
+	size_t pos = 0;
+	while (pos < sorted_names_.size()) {
+		const std::string_view name = sorted_names_[pos];
+		size_t depth = 0;
+		while (depth < previous.size() && depth < name.size() && previous[depth] == name[depth]) {
+			++depth;
+		}
+		previous = name;
+
+		bool is_pruned = false;
+		for (; depth < name.size(); ++depth) {
+			if (rows.size() < depth + 2) {
+				rows.emplace_back(columns);
+				best.push_back(0);
+			}
+			const auto& row = rows[depth];
+			auto& next = rows[depth + 1];
+			next[0] = row[0] + 1;
+			uint32_t row_min = next[0];
+			for (size_t j = 1; j < columns; ++j) {
+				const uint32_t substitution = row[j - 1] + (name[depth] == query[j - 1] ? 0 : 1);
+				next[j] = std::min({row[j] + 1, next[j - 1] + 1, substitution});
+				row_min = std::min(row_min, next[j]);
+			}
+			best[depth + 1] = std::min(best[depth], next[query.size()]);
+			if (row_min > max_errors && best[depth + 1] > max_errors) {
+				// никакое продолжение этого префикса не подойдёт
+				pos = SkipPrefix(pos, name.substr(0, depth + 1));
+				previous = name.substr(0, depth + 1);
+				is_pruned = true;
+				break;
+			}
+		}
+		if (is_pruned) {
+			continue;
+		}
+		if (best[name.size()] <= max_errors) {
+			result.push_back({order_[pos], best[name.size()]});
+		}
+		++pos;
+	}
+
+	std::stable_sort(result.begin(), result.end(), [](const Match& lhs, const Match& rhs) {
+		return lhs.errors < rhs.errors;
+	});
+	if (result.size() > limit) {
+		result.resize(limit);
+	}
+	return result;
+}
+
+memory_usage::Report NameSearchIndex::MemoryUsage() const {
+	memory_usage::Report report;
+	report.Add(memory_usage::OfVector("sorted_names", sorted_names_));
+	report.Add(memory_usage::OfVector("order", order_));
+	return report;
+}
+
+}  // namespace transport_catalogue
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "memory_usage.h"
+
+namespace transport_catalogue {
+
+// Поиск по названиям через упорядоченный массив названий.
+// Названия не копируются: string_view должны жить дольше индекса.
+class NameSearchIndex {
+public:
+	struct Match {
+		uint32_t id;
+		uint32_t errors; // число правок до ближайшего префикса названия
+	};
+
+	NameSearchIndex() = default;
+	// names[id] — название с номером id; order — номера, упорядоченные по названию
+	NameSearchIndex(const std::vector<std::string_view>& names, std::vector<uint32_t> order);
+
+	// упорядочивает номера по названию
+	static std::vector<uint32_t> MakeOrder(const std::vector<std::string_view>& names);
+
+	const std::vector<uint32_t>& GetOrder() const;
+
+	// номер названия, совпадающего с name; из одинаковых названий — наименьший номер
+	std::optional<uint32_t> Find(std::string_view name) const;
+
+	// не больше limit номеров с названиями, начинающимися с prefix, по алфавиту
+	std::vector<uint32_t> FindByPrefix(std::string_view prefix, size_t limit) const;
+
+	// Названия, у которых есть префикс на расстоянии Левенштейна не больше max_errors
+	// от query. Упорядочены по числу правок, затем по алфавиту, не больше limit.
+	// Ветви с общим префиксом, уже превысившим max_errors, пропускаются двоичным поиском
+	std::vector<Match> FindApproximate(std::string_view query, uint32_t max_errors, size_t limit) const;
+
+	memory_usage::Report MemoryUsage() const;
+
+private:
+	std::vector<std::string_view> sorted_names_;
+	std::vector<uint32_t> order_;
+
+	// первая позиция после названий, начинающихся с prefix, начиная с from
+	size_t SkipPrefix(size_t from, std::string_view prefix) const;
+};
+
+}  // namespace transport_catalogue
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Поиск кратчайшего пути алгоритмом Дейкстры на каждый запрос, без предрасчёта.
+// Умеет искать как от начала пути по исходящим рёбрам, так и от конца пути
+// по входящим (для запросов «прибыть к»).
+template <typename Weight>
+class PathSearch {
+private:
+	using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+	struct RouteInfo {
+		Weight weight;
+		std::vector<EdgeId> edges;
+	};
+
+	explicit PathSearch(const Graph& graph);
+
+	std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+	// ищет путь от to к from по входящим рёбрам; рёбра в ответе идут от from к to
+	std::optional<RouteInfo> BuildRouteBackward(VertexId from, VertexId to) const;
+
+private:
+	static constexpr Weight ZERO_WEIGHT{};
+	const Graph& graph_;
+
+	// для каждой достигнутой вершины возвращает ребро, по которому в неё пришёл поиск
+	std::vector<std::optional<EdgeId>> Search(VertexId source, VertexId target, bool backward,
+			std::optional<Weight>& target_weight) const;
+};
+
+template <typename Weight>
+PathSearch<Weight>::PathSearch(const Graph& graph)
+	: graph_(graph)
+{
+}
+
+template <typename Weight>
+std::optional<typename PathSearch<Weight>::RouteInfo>
+PathSearch<Weight>::BuildRoute(VertexId from, VertexId to) const {
+	std::optional<Weight> weight;
+	const auto search_edges = Search(from, to, false, weight);
+	if (!weight) {
+		return std::nullopt;
+	}
+	std::vector<EdgeId> edges;
+	for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(edges.back()).from) {
+		edges.push_back(*search_edges[vertex]);
+	}
+	std::reverse(edges.begin(), edges.end());
+	return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::optional<typename PathSearch<Weight>::RouteInfo>
+PathSearch<Weight>::BuildRouteBackward(VertexId from, VertexId to) const {
+	std::optional<Weight> weight;
+	const auto search_edges = Search(to, from, true, weight);
+	if (!weight) {
+		return std::nullopt;
+	}
+	std::vector<EdgeId> edges;
+	for (VertexId vertex = from; vertex != to; vertex = graph_.GetEdge(edges.back()).to) {
+		edges.push_back(*search_edges[vertex]);
+	}
+	return RouteInfo{*weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::optional<EdgeId>> PathSearch<Weight>::Search(VertexId source, VertexId target,
+		bool backward, std::optional<Weight>& target_weight) const {
+	const size_t vertex_count = graph_.GetVertexCount();
+	if (source >= vertex_count || target >= vertex_count) {
+		throw std::out_of_range("Vertex is out of graph");
+	}
+
+	std::vector<std::optional<Weight>> weights(vertex_count);
+	std::vector<std::optional<EdgeId>> search_edges(vertex_count);
+
+	using QueueItem = std::pair<Weight, VertexId>;
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+	weights[source] = ZERO_WEIGHT;
+	queue.push({ZERO_WEIGHT, source});
+
+	while (!queue.empty()) {
+		const auto [weight, vertex] = queue.top();
+		queue.pop();
+		if (weight > *weights[vertex]) {
+			continue;
+		}
+		if (vertex == target) {
+			target_weight = weight;
+			break;
+		}
+		const auto edge_ids = backward ? graph_.GetIncomingEdges(vertex) : graph_.GetIncidentEdges(vertex);
+		for (const EdgeId edge_id : edge_ids) {
+			const auto& edge = graph_.GetEdge(edge_id);
+			if (edge.weight < ZERO_WEIGHT) {
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+			const VertexId next = backward ? edge.from : edge.to;
+			const Weight candidate = weight + edge.weight;
+			if (!weights[next] || candidate < *weights[next]) {
+				weights[next] = candidate;
+				search_edges[next] = edge_id;
+				queue.push({candidate, next});
+			}
+		}
+	}
+	return search_edges;
+}
+
+}  // namespace graph
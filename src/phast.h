@@ -0,0 +1,109 @@
+#pragma once
+
+#include "contraction_hierarchy.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// PHAST: поиск расстояний от источника до всех вершин поверх иерархии сжатия.
+// Поиск «вверх» из источника, затем один линейный проход «вниз» по позициям.
+// Одновременно обрабатывается до LANES источников: расстояния хранятся
+// чередующимися блоками [позиция][источник], и внутренний цикл прохода
+// векторизуется компилятором.
+template <typename Weight, size_t Lanes = 8>
+class Phast {
+private:
+	using Hierarchy = ContractionHierarchy<Weight>;
+	using Position = typename Hierarchy::Position;
+
+public:
+	static constexpr size_t LANES = Lanes;
+	static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+
+	explicit Phast(const Hierarchy& hierarchy);
+
+	// считает расстояния от sources (не больше LANES штук) до всех вершин
+	void Run(const std::vector<VertexId>& sources);
+
+	// расстояние от источника номер lane последнего запуска до vertex
+	Weight GetDistance(size_t lane, VertexId vertex) const;
+
+private:
+	const Hierarchy& hierarchy_;
+	std::vector<Weight> distances_;
+
+	void SearchUpward(size_t lane, VertexId source);
+	void SweepDownward();
+};
+
+template <typename Weight, size_t Lanes>
+Phast<Weight, Lanes>::Phast(const Hierarchy& hierarchy)
+	: hierarchy_(hierarchy)
+	, distances_(hierarchy.GetVertexCount() * LANES, INFINITE_WEIGHT)
+{
+}
+
+template <typename Weight, size_t Lanes>
+void Phast<Weight, Lanes>::Run(const std::vector<VertexId>& sources) {
+	if (sources.size() > LANES) {
+		throw std::invalid_argument("Too many sources for one PHAST run");
+	}
+	std::fill(distances_.begin(), distances_.end(), INFINITE_WEIGHT);
+	for (size_t lane = 0; lane < sources.size(); ++lane) {
+		SearchUpward(lane, sources[lane]);
+	}
+	SweepDownward();
+}
+
+template <typename Weight, size_t Lanes>
+Weight Phast<Weight, Lanes>::GetDistance(size_t lane, VertexId vertex) const {
+	return distances_[hierarchy_.GetPosition(vertex) * LANES + lane];
+}
+
+template <typename Weight, size_t Lanes>
+void Phast<Weight, Lanes>::SearchUpward(size_t lane, VertexId source) {
+	using QueueItem = std::pair<Weight, Position>;
+	std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+
+	const Position source_position = hierarchy_.GetPosition(source);
+	distances_[source_position * LANES + lane] = Weight{};
+	queue.push({Weight{}, source_position});
+	while (!queue.empty()) {
+		const auto [distance, position] = queue.top();
+		queue.pop();
+		if (distance > distances_[position * LANES + lane]) {
+			continue;
+		}
+		for (const auto& arc : hierarchy_.GetUpwardArcs(position)) {
+			Weight& target = distances_[arc.other * LANES + lane];
+			if (distance + arc.weight < target) {
+				target = distance + arc.weight;
+				queue.push({target, arc.other});
+			}
+		}
+	}
+}
+
+template <typename Weight, size_t Lanes>
+void Phast<Weight, Lanes>::SweepDownward() {
+	const size_t vertex_count = hierarchy_.GetVertexCount();
+	for (size_t position = 0; position < vertex_count; ++position) {
+		Weight* target = distances_.data() + position * LANES;
+		for (const auto& arc : hierarchy_.GetDownwardArcs(static_cast<Position>(position))) {
+			const Weight* source = distances_.data() + arc.other * LANES;
+			for (size_t lane = 0; lane < LANES; ++lane) {
+				target[lane] = std::min(target[lane], source[lane] + arc.weight);
+			}
+		}
+	}
+}
+
+}  // namespace graph
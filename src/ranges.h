@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <iterator>
 #include <string_view>
 #include <unordered_map>
@@ -33,4 +34,31 @@ auto AsRange(const C& container) {
     return Range{container.begin(), container.end()};
 }
 
+// Пересечение двух возрастающих последовательностей без повторов. Элементы
+// короткой последовательности ищутся в длинной галопом: шаг удваивается, пока
+// не перешагнёт искомое, затем двоичный поиск. Для списков сильно разной длины
+// это O(m log(n / m)) вместо O(m + n) у слияния
+template <typename It1, typename It2, typename OutputIt>
+OutputIt IntersectSorted(It1 first1, It1 last1, It2 first2, It2 last2, OutputIt out) {
+    if (std::distance(first1, last1) > std::distance(first2, last2)) {
+        return IntersectSorted(first2, last2, first1, last1, out);
+    }
+    for (; first1 != last1 && first2 != last2; ++first1) {
+        const auto& value = *first1;
+        typename std::iterator_traits<It2>::difference_type step = 1;
+        auto bound = first2;
+        while (std::distance(bound, last2) > step && *std::next(bound, step) < value) {
+            bound = std::next(bound, step);
+            step *= 2;
+        }
+        const auto search_last = std::distance(bound, last2) > step ? std::next(bound, step + 1) : last2;
+        first2 = std::lower_bound(bound, search_last, value);
+        if (first2 != last2 && !(value < *first2)) {
+            *out++ = value;
+            ++first2;
+        }
+    }
+    return out;
+}
+
 }  // namespace ranges
\ No newline at end of file
@@ -1,4 +1,8 @@
+#include <limits>
+
 #include "request_handler.h"
+#include "path_search.h"
+#include "phast.h"
 #include "router.h"
 
 
@@ -17,9 +21,11 @@ graph::Edge<transport_router::Minutes> Edge(const graph_proto::Edge& edge) {
 	return result;
 }
 
-std::optional<graph::Router<transport_router::Minutes>::RouteInternalData>
+// загрузка таблицы маршрутов для graph::Router любой ширины номеров рёбер
+template <typename RouterType>
+std::optional<typename RouterType::RouteInternalData>
 RouteInternalData(const graph_proto::RouteInternalData& route) {
-	graph::Router<transport_router::Minutes>::RouteInternalData result;
+	typename RouterType::RouteInternalData result;
 	if (route.has_data()) {
 		result.weight = route.weight();
 		if (route.has_prev_edge()) {
@@ -33,23 +39,50 @@ RouteInternalData(const graph_proto::RouteInternalData& route) {
 	return result;
 }
 
-std::vector<std::optional<graph::Router<transport_router::Minutes>::RouteInternalData>>
+template <typename RouterType>
+std::vector<std::optional<typename RouterType::RouteInternalData>>
 VectorRouteInternalData(const graph_proto::RoutesInternalData& routes) {
-	std::vector<std::optional<graph::Router<transport_router::Minutes>::RouteInternalData>> result;
+	std::vector<std::optional<typename RouterType::RouteInternalData>> result;
+	result.reserve(routes.route_internal_data_size());
 	for (const auto& route : routes.route_internal_data()) {
-		result.emplace_back(load::RouteInternalData(route));
+		result.emplace_back(load::RouteInternalData<RouterType>(route));
 	}
 	return result;
 }
 
-graph::Router<transport_router::Minutes>::RoutesInternalData RoutesInternalData(const graph_proto::Router& router) {
-	graph::Router<transport_router::Minutes>::RoutesInternalData result;
+template <typename RouterType>
+typename RouterType::RoutesInternalData RoutesInternalData(const graph_proto::Router& router) {
+	typename RouterType::RoutesInternalData result;
+	result.reserve(router.routes_internal_data_size());
 	for (const auto& r : router.routes_internal_data()) {
-		result.emplace_back(load::VectorRouteInternalData(r));
+		result.emplace_back(load::VectorRouteInternalData<RouterType>(r));
 	}
 	return result;
 }
 
+graph::IndexWidth IndexWidth(const transport_catalogue_proto::SnapshotHeader& header) {
+	switch (header.index_width()) {
+	case 16:
+		return graph::IndexWidth::U16;
+	case 32:
+		return graph::IndexWidth::U32;
+	default:
+		return graph::IndexWidth::U64;
+	}
+}
+
+geo::Grid::Layout StopIndexLayout(const transport_catalogue_proto::StopIndex& stop_index) {
+	geo::Grid::Layout result;
+	result.min = {stop_index.min().lat(), stop_index.min().lng()};
+	result.cell_lat = stop_index.cell_lat();
+	result.cell_lng = stop_index.cell_lng();
+	result.rows = stop_index.rows();
+	result.cols = stop_index.cols();
+	result.cell_begin.assign(stop_index.cell_begin().begin(), stop_index.cell_begin().end());
+	result.ids.assign(stop_index.stop_id().begin(), stop_index.stop_id().end());
+	return result;
+}
+
 }  // namespace load
 
 }  // namespace detail
@@ -64,6 +97,10 @@ RequestHandler::RequestHandler (const TransportCatalogue& db,
 	, router_(router)
 	{}
 
+const TransportCatalogue& RequestHandler::GetTransportCatalogue() const {
+	return db_;
+}
+
 std::optional<domain::BusStat>
 RequestHandler::GetBusStat(std::string_view bus_name) const {
 	const auto bus = db_.FindBus(bus_name);
@@ -74,13 +111,13 @@ RequestHandler::GetBusStat(std::string_view bus_name) const {
 	}
 }
 
-std::optional<std::unordered_set<domain::BusPtr>>
+std::optional<ranges::Range<std::vector<domain::BusId>::const_iterator>>
 RequestHandler::GetBusesByStop(std::string_view stop_name) const {
 	const auto stop = db_.FindStop(stop_name);
 	if (!stop) {
 		return std::nullopt;
 	} else {
-		return db_.GetStopInfo(stop);
+		return ranges::AsRange(db_.GetBusIdsByStop(stop->id));
 	}
 }
 
@@ -120,6 +157,13 @@ RequestHandlerProto::RequestHandlerProto(
 	, renderer_(renderer)
 	{}
 
+RequestHandlerProto::~RequestHandlerProto() {
+	if (router_builder_.joinable()) {
+		router_ptr_->CancelBuild();
+		router_builder_.join();
+	}
+}
+
 void RequestHandlerProto::FillGraph() {
 	const auto& graph = db_.transport_router().graph();
 	graph_ptr_ = std::make_unique<graph::DirectedWeightedGraph<transport_router::Minutes>>(graph.vertex_count());
@@ -128,8 +172,86 @@ void RequestHandlerProto::FillGraph() {
 	}
 }
 void RequestHandlerProto::FillRouter() {
-	router_ptr_ = std::make_unique<graph::Router<transport_router::Minutes>>(*graph_ptr_);
-	router_ptr_->SetRoutesInternalData(std::move(detail::load::RoutesInternalData(db_.transport_router().router())));
+	if (db_.transport_router().engine() == transport_router_proto::SEARCH) {
+		return;
+	}
+	router_ptr_ = std::make_unique<graph::RouterOfWidth<transport_router::Minutes>>(*graph_ptr_,
+			detail::load::IndexWidth(db_.header()));
+	if (db_.transport_router().has_router()) {
+		router_ptr_->Visit([this](auto& router) {
+			using RouterType = std::decay_t<decltype(router)>;
+			router.SetRoutesInternalData(detail::load::RoutesInternalData<RouterType>(db_.transport_router().router()));
+		});
+		is_router_ready_.store(true, std::memory_order_release);
+		return;
+	}
+	router_builder_ = std::thread([this]() {
+		router_ptr_->Build();
+		if (router_ptr_->GetBuildProgress() == graph_ptr_->GetVertexCount()) {
+			is_router_ready_.store(true, std::memory_order_release);
+		}
+	});
+}
+
+void RequestHandlerProto::FillStopIndex() {
+	const auto& transport_catalogue = db_.transport_catalogue();
+	std::vector<geo::Coordinates> coordinates;
+	coordinates.reserve(transport_catalogue.stop_size());
+	for (const auto& stop : transport_catalogue.stop()) {
+		coordinates.push_back({stop.coordinates().lat(), stop.coordinates().lng()});
+	}
+	// в базах без сохранённой сетки она строится заново
+	stop_index_ = transport_catalogue.has_stop_index()
+			? geo::Grid(detail::load::StopIndexLayout(transport_catalogue.stop_index()), coordinates)
+			: geo::Grid(coordinates);
+}
+
+std::vector<geo::Grid::Neighbour>
+RequestHandlerProto::FindNearestStops(geo::Coordinates point, size_t count) const {
+	return stop_index_.FindNearest(point, count);
+}
+
+std::vector<uint32_t> RequestHandlerProto::FindStopsInBox(geo::Coordinates min, geo::Coordinates max) const {
+	return stop_index_.FindInBox(min, max);
+}
+
+void RequestHandlerProto::FillStopNameIndex() {
+	const auto& transport_catalogue = db_.transport_catalogue();
+	std::vector<std::string_view> names;
+	names.reserve(transport_catalogue.stop_size());
+	for (const auto& stop : transport_catalogue.stop()) {
+		names.push_back(serialization::GetName(transport_catalogue, stop));
+	}
+	const auto& order = transport_catalogue.stop_id_by_name();
+	stop_name_index_ = order.size() == transport_catalogue.stop_size()
+			? NameSearchIndex(names, {order.begin(), order.end()})
+			: NameSearchIndex(names, NameSearchIndex::MakeOrder(names));
+}
+
+std::vector<uint32_t> RequestHandlerProto::SearchStopsByPrefix(std::string_view prefix, size_t limit) const {
+	return stop_name_index_.FindByPrefix(prefix, limit);
+}
+
+std::vector<NameSearchIndex::Match> RequestHandlerProto::SearchStopsApproximately(std::string_view query,
+		uint32_t max_errors, size_t limit) const {
+	return stop_name_index_.FindApproximate(query, max_errors, limit);
+}
+
+RequestHandlerProto::RouterStatus RequestHandlerProto::GetRouterStatus() const {
+	RouterStatus result;
+	result.is_table_engine = db_.transport_router().engine() != transport_router_proto::SEARCH;
+	result.is_ready = is_router_ready_.load(std::memory_order_acquire);
+	const size_t vertex_count = graph_ptr_ ? graph_ptr_->GetVertexCount() : 0;
+	if (result.is_ready || !vertex_count) {
+		result.progress = 1.;
+	} else if (router_ptr_) {
+		result.progress = static_cast<double>(router_ptr_->GetBuildProgress()) / vertex_count;
+	}
+	return result;
+}
+
+void RequestHandlerProto::FillContractionHierarchy() {
+	hierarchy_ptr_ = std::make_unique<graph::ContractionHierarchy<transport_router::Minutes>>(*graph_ptr_);
 }
 
 const transport_catalogue_proto::TransportCatalogue&
@@ -137,30 +259,83 @@ RequestHandlerProto::GetTransportCatalogue() const {
 	return db_.transport_catalogue();
 }
 
-std::optional<transport_catalogue_proto::Bus>
+const transport_catalogue_proto::Stop*
+RequestHandlerProto::FindStop(std::string_view stop_name) const {
+	const auto& transport_catalogue = db_.transport_catalogue();
+	if (stop_name_index_.GetOrder().size() == static_cast<size_t>(transport_catalogue.stop_size())) {
+		const auto stop_id = stop_name_index_.Find(stop_name);
+		return stop_id ? &transport_catalogue.stop(*stop_id) : nullptr;
+	}
+	const auto& stops = transport_catalogue.stop();
+	const auto iter = detail::FindByName(transport_catalogue, stops.begin(), stops.end(), stop_name);
+	return iter == stops.end() ? nullptr : &*iter;
+}
+
+const transport_catalogue_proto::Bus*
 RequestHandlerProto::GetBusStat(std::string_view bus_name) const {
 	const auto& buses = db_.transport_catalogue().bus();
-	const auto bus_stat_iter = detail::FindByName(buses.begin(), buses.end(), bus_name);
+	const auto bus_stat_iter = detail::FindByName(db_.transport_catalogue(), buses.begin(), buses.end(), bus_name);
 	if (bus_stat_iter == buses.end()) {
+		return nullptr;
+	}
+	return &*bus_stat_iter;
+}
+
+std::optional<RequestHandlerProto::SegmentDistance>
+RequestHandlerProto::GetSegmentDistance(std::string_view bus_name, size_t from, size_t to) const {
+	const auto bus = GetBusStat(bus_name);
+	if (!bus || from > to || to >= static_cast<size_t>(bus->road_distance_prefix_size())) {
+		return std::nullopt;
+	}
+	const auto& road = bus->road_distance_prefix();
+	const auto& geo = bus->geo_distance_prefix();
+	return SegmentDistance{road[to] - road[from], geo[to] - geo[from]};
+}
+
+std::optional<std::vector<uint32_t>>
+RequestHandlerProto::FindDirectBuses(std::string_view from_name, std::string_view to_name) const {
+	const auto& transport_catalogue = db_.transport_catalogue();
+	const auto from = FindStop(from_name);
+	const auto to = FindStop(to_name);
+	if (!from || !to) {
 		return std::nullopt;
 	}
-	return *bus_stat_iter;
+
+	std::vector<uint32_t> candidates;
+	ranges::IntersectSorted(from->bus_posting().begin(), from->bus_posting().end(),
+			to->bus_posting().begin(), to->bus_posting().end(), std::back_inserter(candidates));
+
+	const auto find_position = [](const transport_catalogue_proto::Bus& bus, uint64_t stop_id) {
+		const auto& stop_ids = bus.position_stop_id();
+		return std::lower_bound(stop_ids.begin(), stop_ids.end(), stop_id) - stop_ids.begin();
+	};
+
+	std::vector<uint32_t> result;
+	for (const auto bus_id : candidates) {
+		const auto& bus = transport_catalogue.bus(bus_id);
+		// обе остановки есть на маршруте, поэтому поиск всегда успешен
+		const auto from_index = find_position(bus, from->id());
+		const auto to_index = find_position(bus, to->id());
+		if (bus.first_position(from_index) < bus.last_position(to_index)) {
+			result.push_back(bus_id);
+		}
+	}
+	std::sort(result.begin(), result.end(), [&transport_catalogue](uint32_t lhs, uint32_t rhs) {
+		return serialization::GetName(transport_catalogue, transport_catalogue.bus(lhs))
+				< serialization::GetName(transport_catalogue, transport_catalogue.bus(rhs));
+	});
+	return result;
 }
 
-std::optional<std::set<std::string_view>>
+std::optional<ranges::Range<google::protobuf::RepeatedField<uint64_t>::const_iterator>>
 RequestHandlerProto::GetBusesByStop(std::string_view stop_name) const {
 	const auto& stops = db_.transport_catalogue().stop();
-	const auto stop_stat_iter = detail::FindByName(stops.begin(), stops.end(), stop_name);
+	const auto stop_stat_iter = detail::FindByName(db_.transport_catalogue(), stops.begin(), stops.end(), stop_name);
 
 	if (stop_stat_iter == stops.end()) {
 		return std::nullopt;
 	}
-
-	std::set<std::string_view> sorted_bus_names;
-	for (const auto& bus_id : stop_stat_iter->bus_id()) {
-		sorted_bus_names.insert(db_.transport_catalogue().bus(bus_id).name());
-	}
-	return sorted_bus_names;
+	return ranges::AsRange(stop_stat_iter->bus_id());
 }
 
 const svg::Document& RequestHandlerProto::RenderMap() const {
@@ -169,10 +344,49 @@ const svg::Document& RequestHandlerProto::RenderMap() const {
 
 std::optional<transport_router_proto::RouteInfo>
 RequestHandlerProto::GetRouteInfo(std::string_view from_name, std::string_view to_name) const {
+	const auto& vertex_ids = FindRouteVertexIds(from_name, to_name);
+	if (!vertex_ids) {
+		return std::nullopt;
+	}
 
+	if (!is_router_ready_.load(std::memory_order_acquire)) {
+		const auto& route_info = graph::PathSearch<transport_router::Minutes>(*graph_ptr_)
+				.BuildRoute(vertex_ids->first, vertex_ids->second);
+		if (!route_info) {
+			return std::nullopt;
+		}
+		return MakeRouteInfo(route_info->weight, route_info->edges);
+	}
+
+	const auto& route_info = router_ptr_->BuildRoute(vertex_ids->first, vertex_ids->second);
+	if (!route_info) {
+		return std::nullopt;
+	}
+
+	return MakeRouteInfo(route_info->weight, route_info->edges);
+}
+
+std::optional<transport_router_proto::RouteInfo>
+RequestHandlerProto::GetArriveByRouteInfo(std::string_view from_name, std::string_view to_name) const {
+	const auto& vertex_ids = FindRouteVertexIds(from_name, to_name);
+	if (!vertex_ids) {
+		return std::nullopt;
+	}
+
+	const auto& route_info = graph::PathSearch<transport_router::Minutes>(*graph_ptr_)
+			.BuildRouteBackward(vertex_ids->first, vertex_ids->second);
+	if (!route_info) {
+		return std::nullopt;
+	}
+
+	return MakeRouteInfo(route_info->weight, route_info->edges);
+}
+
+std::optional<std::pair<graph::VertexId, graph::VertexId>>
+RequestHandlerProto::FindRouteVertexIds(std::string_view from_name, std::string_view to_name) const {
 	const auto& stops = db_.transport_catalogue().stop();
-	const auto from_iter = detail::FindByName(stops.begin(), stops.end(), from_name);
-	const auto to_iter = detail::FindByName(stops.begin(), stops.end(), to_name);
+	const auto from_iter = detail::FindByName(db_.transport_catalogue(), stops.begin(), stops.end(), from_name);
+	const auto to_iter = detail::FindByName(db_.transport_catalogue(), stops.begin(), stops.end(), to_name);
 	if (from_iter == stops.end() || to_iter == stops.end()) {
 		return std::nullopt;
 	}
@@ -182,23 +396,99 @@ RequestHandlerProto::GetRouteInfo(std::string_view from_name, std::string_view t
 		return std::nullopt;
 	}
 
-	uint64_t begin_id = stop_id_to_vertex_ids.at(from_iter->id()).bus_wait_begin();
-	uint64_t end_id = stop_id_to_vertex_ids.at(to_iter->id()).bus_wait_begin();
-
-	const auto& route_info = router_ptr_->BuildRoute(begin_id, end_id);
-	if (!route_info) {
-		return std::nullopt;
-	}
+	return std::make_pair(stop_id_to_vertex_ids.at(from_iter->id()).bus_wait_begin(),
+			stop_id_to_vertex_ids.at(to_iter->id()).bus_wait_begin());
+}
 
+transport_router_proto::RouteInfo RequestHandlerProto::MakeRouteInfo(transport_router::Minutes total_time,
+		const std::vector<graph::EdgeId>& edges) const {
 	transport_router_proto::RouteInfo result;
-	result.set_total_time(route_info->weight);
-	for (const auto edge_id : route_info->edges) {
+	result.set_total_time(total_time);
+	for (const auto edge_id : edges) {
 		const auto& edge_info = db_.transport_router().edge_id_to_edge_info().at(edge_id);
 		*result.add_edge_info() = edge_info;
 	}
-
 	return result;
 }
 
+void RequestHandlerProto::ComputeTravelTimes(const std::vector<uint64_t>& origin_stop_ids,
+		const TravelTimesRowCallback& callback) const {
+	using Phast = graph::Phast<transport_router::Minutes>;
+
+	const auto& stop_id_to_vertex_ids = db_.transport_router().stop_id_to_pair_vertex_id();
+	const size_t stop_count = db_.transport_catalogue().stop_size();
+	const graph::VertexId NO_VERTEX = std::numeric_limits<graph::VertexId>::max();
+	Phast phast(*hierarchy_ptr_);
+
+	// вершина ожидания на каждой остановке, чтобы не искать её в карте базы для каждой ячейки матрицы
+	std::vector<graph::VertexId> stop_vertex_ids(stop_count, NO_VERTEX);
+	for (const auto& [stop_id, vertex_ids] : stop_id_to_vertex_ids) {
+		if (stop_id < stop_count) {
+			stop_vertex_ids[stop_id] = vertex_ids.bus_wait_begin();
+		}
+	}
+
+	std::vector<uint64_t> batch_stop_ids;
+	std::vector<graph::VertexId> batch_sources;
+	std::vector<transport_router::Minutes> row(stop_count);
+
+	auto flush_batch = [&]() {
+		phast.Run(batch_sources);
+		for (size_t lane = 0; lane < batch_stop_ids.size(); ++lane) {
+			for (size_t stop_id = 0; stop_id < stop_count; ++stop_id) {
+				const graph::VertexId vertex_id = stop_vertex_ids[stop_id];
+				row[stop_id] = vertex_id == NO_VERTEX
+						? Phast::INFINITE_WEIGHT
+						: phast.GetDistance(lane, vertex_id);
+			}
+			callback(batch_stop_ids[lane], row);
+		}
+		batch_stop_ids.clear();
+		batch_sources.clear();
+	};
+
+	for (const auto stop_id : origin_stop_ids) {
+		if (stop_id >= stop_count || stop_vertex_ids[stop_id] == NO_VERTEX) {
+			std::fill(row.begin(), row.end(), Phast::INFINITE_WEIGHT);
+			callback(stop_id, row);
+			continue;
+		}
+		batch_stop_ids.push_back(stop_id);
+		batch_sources.push_back(stop_vertex_ids[stop_id]);
+		if (batch_sources.size() == Phast::LANES) {
+			flush_batch();
+		}
+	}
+	if (!batch_sources.empty()) {
+		flush_batch();
+	}
+}
+
+memory_usage::Report RequestHandlerProto::MemoryUsage() const {
+	using namespace memory_usage;
+
+	// protobuf сообщает только занятые байты; количество выделений не учитывается
+	Report report;
+	const auto& transport_catalogue = db_.transport_catalogue();
+	const size_t catalogue_size = transport_catalogue.stop_size() + transport_catalogue.bus_size();
+	report.Add({"db.transport_catalogue", static_cast<size_t>(transport_catalogue.SpaceUsedLong()), 0, catalogue_size, catalogue_size});
+	report.Add({"db.map_renderer", static_cast<size_t>(db_.map_renderer().SpaceUsedLong()), 0, 0, 0});
+	report.Add({"db.transport_router", static_cast<size_t>(db_.transport_router().SpaceUsedLong()), 0, 0, 0});
+
+	if (graph_ptr_) {
+		report.Append("graph", graph_ptr_->MemoryUsage());
+	}
+	if (router_ptr_) {
+		report.Add(router_ptr_->MemoryUsage());
+	}
+	if (hierarchy_ptr_) {
+		report.Append("contraction_hierarchy", hierarchy_ptr_->MemoryUsage());
+	}
+	report.Append("stop_index", stop_index_.MemoryUsage());
+	report.Append("stop_name_index", stop_name_index_.MemoryUsage());
+	report.Append("renderer", renderer_.MemoryUsage());
+	return report;
+}
+
 }  // transport_catalogue::request_handler
 
@@ -1,15 +1,26 @@
 #pragma once
 
+#include <atomic>
+#include <functional>
 #include <optional>
+#include <thread>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include <transport_catalogue.pb.h>
 #include <graph.pb.h>
 #include <transport_router.pb.h>
 
+#include "contraction_hierarchy.h"
+#include "geo_grid.h"
 #include "map_renderer.h"
+#include "memory_usage.h"
+#include "name_search.h"
+#include "ranges.h"
 #include "svg.h"
 #include "router.h"
+#include "serialization.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
@@ -19,10 +30,11 @@ namespace transport_catalogue::request_handler {
 namespace detail {
 
 template <typename InputIt>
-InputIt FindByName(InputIt first, InputIt last, std::string_view name) {
+InputIt FindByName(const transport_catalogue_proto::TransportCatalogue& transport_catalogue,
+		InputIt first, InputIt last, std::string_view name) {
 	InputIt result = last;
 	for (auto iter = first; iter != last; ++iter) {
-		if (iter->name() == name) {
+		if (serialization::GetName(transport_catalogue, *iter) == name) {
 			result = iter;
 			break;
 		}
@@ -38,12 +50,14 @@ public:
 			const renderer::MapRenderer& renderer,
 			const transport_router::TransportRouter& router);
 
+	const TransportCatalogue& GetTransportCatalogue() const;
+
 	// Возвращает информацию о маршруте (запрос Bus)
 	std::optional<domain::BusStat>
 	GetBusStat(std::string_view bus_name) const;
 
-	// Возвращает маршруты, проходящие через остановку
-	std::optional<std::unordered_set<domain::BusPtr>>
+	// Возвращает номера маршрутов, проходящих через остановку, упорядоченные по названию
+	std::optional<ranges::Range<std::vector<domain::BusId>::const_iterator>>
 	GetBusesByStop(std::string_view stop_name) const;
 
 	const svg::Document& RenderMap() const;
@@ -63,16 +77,45 @@ public:
 	RequestHandlerProto(const transport_catalogue_proto::DataBase& db,
 			const renderer::MapRenderer& renderer
 			);
+	~RequestHandlerProto();
 
 	void FillGraph();
+	// Загружает таблицу маршрутов из базы. Если в базе её нет, запускает построение
+	// таблицы в фоновом потоке; до его окончания маршруты ищутся поиском на каждый запрос.
+	// Для базы со способом маршрутизации SEARCH таблица не строится вовсе
 	void FillRouter();
+	void FillContractionHierarchy();
 
 	const transport_catalogue_proto::TransportCatalogue& GetTransportCatalogue() const;
 
-	std::optional<transport_catalogue_proto::Bus>
+	// Остановка из базы либо nullptr. Ищется по индексу названий, если он
+	// загружен FillStopNameIndex, иначе перебором
+	const transport_catalogue_proto::Stop*
+	FindStop(std::string_view stop_name) const;
+
+	// маршрут из базы либо nullptr
+	const transport_catalogue_proto::Bus*
 	GetBusStat(std::string_view bus_name) const;
 
-	std::optional<std::set<std::string_view>>
+	struct SegmentDistance {
+		uint64_t road = 0; // м
+		double geo = 0.; // сумма расстояний по прямой между соседними остановками, м
+	};
+
+	// Длина участка пути маршрута между позициями from <= to. Позиции нумеруют
+	// остановки пути, у некольцевого маршрута включая обратное направление
+	std::optional<SegmentDistance>
+	GetSegmentDistance(std::string_view bus_name, size_t from, size_t to) const;
+
+	// Номера маршрутов, на которых можно доехать от остановки from_name до to_name
+	// без пересадки, упорядоченные по названию. Списки маршрутов остановок
+	// пересекаются, затем порядок остановок проверяется по индексу позиций маршрута.
+	// Если остановки нет в базе, возвращает nullopt
+	std::optional<std::vector<uint32_t>>
+	FindDirectBuses(std::string_view from_name, std::string_view to_name) const;
+
+	// номера маршрутов остановки из базы, уже упорядоченные по названию
+	std::optional<ranges::Range<google::protobuf::RepeatedField<uint64_t>::const_iterator>>
 	GetBusesByStop(std::string_view stop_name) const;
 
 	const svg::Document& RenderMap() const;
@@ -80,11 +123,66 @@ public:
 	std::optional<transport_router_proto::RouteInfo>
 	GetRouteInfo(std::string_view from_name, std::string_view to_name) const;
 
+	struct RouterStatus {
+		bool is_table_engine = true; // иначе маршруты всегда ищутся поиском на каждый запрос
+		bool is_ready = false;
+		double progress = 0.; // доля построенной таблицы маршрутов, от 0 до 1
+	};
+
+	RouterStatus GetRouterStatus() const;
+
+	// Загружает сетку остановок из базы. Требуется для FindNearestStops и FindStopsInBox
+	void FillStopIndex();
+
+	// не больше count ближайших к point остановок, по возрастанию расстояния
+	std::vector<geo::Grid::Neighbour> FindNearestStops(geo::Coordinates point, size_t count) const;
+
+	// номера остановок внутри прямоугольника координат
+	std::vector<uint32_t> FindStopsInBox(geo::Coordinates min, geo::Coordinates max) const;
+
+	// Загружает упорядоченный список названий остановок. Названия в индексе
+	// ссылаются на блок названий базы
+	void FillStopNameIndex();
+
+	// номера остановок с названиями, начинающимися с prefix, по алфавиту
+	std::vector<uint32_t> SearchStopsByPrefix(std::string_view prefix, size_t limit) const;
+
+	// остановки, начало названия которых отличается от query не больше чем на max_errors правок
+	std::vector<NameSearchIndex::Match> SearchStopsApproximately(std::string_view query,
+			uint32_t max_errors, size_t limit) const;
+
+	// Тот же маршрут, но поиск ведётся от конечной остановки по входящим рёбрам
+	std::optional<transport_router_proto::RouteInfo>
+	GetArriveByRouteInfo(std::string_view from_name, std::string_view to_name) const;
+
+	using TravelTimesRowCallback = std::function<void(uint64_t, const std::vector<transport_router::Minutes>&)>;
+
+	// Считает время в пути от каждой остановки origin_stop_ids до всех остановок справочника.
+	// Строки матрицы передаются в callback по мере готовности, недостижимым остановкам
+	// соответствует бесконечность. Требует FillContractionHierarchy()
+	void ComputeTravelTimes(const std::vector<uint64_t>& origin_stop_ids,
+			const TravelTimesRowCallback& callback) const;
+
+	// память загруженной базы и построенных по ней структур, включая карту
+	memory_usage::Report MemoryUsage() const;
+
 private:
 	const transport_catalogue_proto::DataBase& db_;
 	const renderer::MapRenderer& renderer_;
 	std::unique_ptr<graph::DirectedWeightedGraph<transport_router::Minutes>> graph_ptr_;
-	std::unique_ptr<graph::Router<transport_router::Minutes>> router_ptr_;
+	std::unique_ptr<graph::RouterOfWidth<transport_router::Minutes>> router_ptr_;
+	std::atomic<bool> is_router_ready_ = false;
+	std::thread router_builder_;
+	std::unique_ptr<graph::ContractionHierarchy<transport_router::Minutes>> hierarchy_ptr_;
+	geo::Grid stop_index_;
+	NameSearchIndex stop_name_index_;
+
+	// вершины ожидания автобуса на остановках from_name и to_name
+	std::optional<std::pair<graph::VertexId, graph::VertexId>>
+	FindRouteVertexIds(std::string_view from_name, std::string_view to_name) const;
+
+	transport_router_proto::RouteInfo MakeRouteInfo(transport_router::Minutes total_time,
+			const std::vector<graph::EdgeId>& edges) const;
 };
 
 }  // transport_catalogue::request_handler
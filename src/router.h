@@ -1,21 +1,26 @@
 #pragma once
 
 #include "graph.h"
+#include "memory_usage.h"
 #include "ranges.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <memory>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
+#include <variant>
 #include <vector>
 
 namespace graph {
 
-template <typename Weight>
+// Index — тип номеров рёбер в таблице маршрутов, см. IndexWidth
+template <typename Weight, typename Index = EdgeId>
 class Router {
 private:
 	using Graph = DirectedWeightedGraph<Weight>;
@@ -23,7 +28,7 @@ private:
 public:
 	struct RouteInternalData {
 		Weight weight;
-		std::optional<EdgeId> prev_edge;
+		std::optional<Index> prev_edge;
 	};
 	using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 	using RoutesInternalDataRange = ranges::Range<typename RoutesInternalData::const_iterator>;
@@ -37,6 +42,7 @@ public:
 
 	void SetRoutesInternalData(RoutesInternalData data) {
 		routes_internal_data_ = std::move(data);
+		relaxed_vertex_count_.store(graph_.GetVertexCount(), std::memory_order_release);
 	}
 
 	RoutesInternalDataRange GetRoutesInternalDataRange() const;
@@ -46,12 +52,34 @@ public:
 
 		const size_t vertex_count = graph_.GetVertexCount();
 		for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+			if (build_cancelled_.load(std::memory_order_relaxed)) {
+				return;
+			}
 			RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+			relaxed_vertex_count_.store(vertex_through + 1, std::memory_order_release);
 		}
 	}
 
+	// Количество вершин, через которые уже выполнена релаксация.
+	// Можно читать из другого потока во время Build; таблица готова,
+	// когда значение равно количеству вершин графа
+	size_t GetBuildProgress() const {
+		return relaxed_vertex_count_.load(std::memory_order_acquire);
+	}
+
+	// прерывает Build, запущенный в другом потоке; таблица остаётся неполной
+	void CancelBuild() {
+		build_cancelled_.store(true, std::memory_order_relaxed);
+	}
+
 	std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+	// таблица маршрутов; выделяется целиком в конструкторе, поэтому её можно
+	// оценивать и во время Build в другом потоке
+	memory_usage::Item MemoryUsage() const {
+		return memory_usage::OfNestedVector("routes_internal_data", routes_internal_data_);
+	}
+
 private:
 
 
@@ -66,7 +94,7 @@ private:
 				}
 				auto& route_internal_data = routes_internal_data_[vertex][edge.to];
 				if (!route_internal_data || route_internal_data->weight > edge.weight) {
-					route_internal_data = RouteInternalData{edge.weight, edge_id};
+					route_internal_data = RouteInternalData{edge.weight, static_cast<Index>(edge_id)};
 				}
 			}
 		}
@@ -98,19 +126,21 @@ private:
 	static constexpr Weight ZERO_WEIGHT{};
 	const Graph& graph_;
 	RoutesInternalData routes_internal_data_;
+	std::atomic<size_t> relaxed_vertex_count_ = 0;
+	std::atomic<bool> build_cancelled_ = false;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename Index>
+Router<Weight, Index>::Router(const Graph& graph)
 	: graph_(graph)
 	, routes_internal_data_(graph.GetVertexCount(),
 							std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
 {
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-																			 VertexId to) const {
+template <typename Weight, typename Index>
+std::optional<typename Router<Weight, Index>::RouteInfo> Router<Weight, Index>::BuildRoute(VertexId from,
+																						   VertexId to) const {
 	const auto& route_internal_data = routes_internal_data_.at(from).at(to);
 	if (!route_internal_data) {
 		return std::nullopt;
@@ -128,10 +158,82 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
 	return RouteInfo{weight, std::move(edges)};
 }
 
-template <typename Weight>
-typename Router<Weight>::RoutesInternalDataRange
-Router<Weight>::GetRoutesInternalDataRange() const {
+template <typename Weight, typename Index>
+typename Router<Weight, Index>::RoutesInternalDataRange
+Router<Weight, Index>::GetRoutesInternalDataRange() const {
 	return ranges::AsRange(routes_internal_data_);
 }
 
+// Router, ширина номеров рёбер которого выбирается во время выполнения
+template <typename Weight>
+class RouterOfWidth {
+public:
+	using RouteInfo = typename Router<Weight>::RouteInfo;
+
+	RouterOfWidth(const DirectedWeightedGraph<Weight>& graph, IndexWidth width)
+		: width_(width) {
+		DispatchIndexWidth(width, [this, &graph](auto index) {
+			routers_ = std::make_unique<Router<Weight, decltype(index)>>(graph);
+		});
+	}
+
+	IndexWidth GetIndexWidth() const {
+		return width_;
+	}
+
+	// вызывает visitor(router) для Router выбранной ширины
+	template <typename Visitor>
+	decltype(auto) Visit(Visitor&& visitor) {
+		return std::visit([&visitor](auto& router) -> decltype(auto) {
+			return visitor(*router);
+		}, routers_);
+	}
+	template <typename Visitor>
+	decltype(auto) Visit(Visitor&& visitor) const {
+		return std::visit([&visitor](const auto& router) -> decltype(auto) {
+			return visitor(std::as_const(*router));
+		}, routers_);
+	}
+
+	void Build() {
+		Visit([](auto& router) {
+			router.Build();
+		});
+	}
+
+	size_t GetBuildProgress() const {
+		return Visit([](const auto& router) {
+			return router.GetBuildProgress();
+		});
+	}
+
+	void CancelBuild() {
+		Visit([](auto& router) {
+			router.CancelBuild();
+		});
+	}
+
+	std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const {
+		return Visit([from, to](const auto& router) -> std::optional<RouteInfo> {
+			auto route = router.BuildRoute(from, to);
+			if (!route) {
+				return std::nullopt;
+			}
+			return RouteInfo{route->weight, std::move(route->edges)};
+		});
+	}
+
+	memory_usage::Item MemoryUsage() const {
+		return Visit([](const auto& router) {
+			return router.MemoryUsage();
+		});
+	}
+
+private:
+	IndexWidth width_;
+	std::variant<std::unique_ptr<Router<Weight, uint16_t>>,
+			std::unique_ptr<Router<Weight, uint32_t>>,
+			std::unique_ptr<Router<Weight, uint64_t>>> routers_;
+};
+
 }  // namespace graph
@@ -2,11 +2,18 @@
 #include <cassert>
 #include <deque>
 #include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "serialization.h"
 
 #include "domain.h"
+#include "geo_grid.h"
 #include "map_renderer.h"
+#include "name_search.h"
 
 
 
@@ -17,10 +24,9 @@ namespace {
 namespace make {
 svg_proto::Rgba Rgba(const svg::Rgb& rgb);
 svg_proto::Rgba Rgba(const svg::Rgba& rgba);
-transport_router_proto::WaitEdgeInfo WaitEdgeInfo(const transport_router::WaitEdgeInfo& edge_info,
-		const std::deque<domain::Stop>& stops);
-transport_router_proto::BusEdgeInfo BusEdgeInfo(const transport_router::BusEdgeInfo& edge_info,
-		const std::deque<domain::Bus>& buses);
+transport_router_proto::WaitEdgeInfo WaitEdgeInfo(const transport_router::WaitEdgeInfo& edge_info);
+transport_router_proto::BusEdgeInfo BusEdgeInfo(const transport_router::BusEdgeInfo& edge_info);
+transport_router_proto::WalkEdgeInfo WalkEdgeInfo(const transport_router::WalkEdgeInfo& edge_info);
 }  // namespace make
 
 namespace detail {
@@ -48,35 +54,48 @@ struct ColorGetter {
 	}
 };
 
-const uint64_t GetStopId(std::string_view stop_name, const std::deque<domain::Stop>& stops) {
-	const auto pos = std::find_if(stops.begin(), stops.end(),
-			[&stop_name](const domain::Stop& stop) { return stop.name == stop_name;});
-	assert(pos != stops.end());
-	return static_cast<uint64_t>(std::distance(stops.begin(), pos));
-}
-const uint64_t GetBusId(std::string_view bus_name, const std::deque<domain::Bus>& buses) {
-	const auto pos = std::find_if(buses.begin(), buses.end(),
-			[&bus_name](const domain::Bus& bus) { return bus.name == bus_name;});
-	assert(pos != buses.end());
-	return static_cast<uint64_t>(std::distance(buses.begin(), pos));
-}
-
 struct EdgeInfoGetter {
-	const transport_catalogue::TransportCatalogue& transport_catalogue;
 	transport_router_proto::EdgeInfo operator()(const transport_router::WaitEdgeInfo& edge_info) {
 		transport_router_proto::EdgeInfo result;
-		const auto& stops = transport_catalogue.GetStops();
-		*result.mutable_wait_edge_info() = std::move(make::WaitEdgeInfo(edge_info, stops));
+		*result.mutable_wait_edge_info() = std::move(make::WaitEdgeInfo(edge_info));
 		return result;
 	}
 	transport_router_proto::EdgeInfo operator()(const transport_router::BusEdgeInfo& edge_info) {
 		transport_router_proto::EdgeInfo result;
-		const auto& buses = transport_catalogue.GetBuses();
-		*result.mutable_bus_edge_info() = std::move(make::BusEdgeInfo(edge_info, buses));
+		*result.mutable_bus_edge_info() = std::move(make::BusEdgeInfo(edge_info));
+		return result;
+	}
+	transport_router_proto::EdgeInfo operator()(const transport_router::WalkEdgeInfo& edge_info) {
+		transport_router_proto::EdgeInfo result;
+		*result.mutable_walk_edge_info() = std::move(make::WalkEdgeInfo(edge_info));
 		return result;
 	}
 };
 
+// Собирает названия в один блок. Названия из справочника уже без повторов,
+// поэтому одинаковые названия узнаются по адресу
+class NamesBlob {
+public:
+	transport_catalogue_proto::NameHandle Add(std::string_view name) {
+		auto [iter, inserted] = handles_.emplace(name.data(), transport_catalogue_proto::NameHandle{});
+		if (inserted) {
+			iter->second.set_offset(static_cast<uint32_t>(blob_.size()));
+			iter->second.set_length(static_cast<uint32_t>(name.size()));
+			blob_.append(name);
+		}
+		return iter->second;
+	}
+
+	std::string Release() {
+		handles_.clear();
+		return std::move(blob_);
+	}
+
+private:
+	std::string blob_;
+	std::unordered_map<const char*, transport_catalogue_proto::NameHandle> handles_;
+};
+
 }  // namespace detail
 
 namespace make {
@@ -88,33 +107,49 @@ transport_catalogue_proto::Coordinates Coordinates(const domain::Stop& stop) {
 	return coordinates;
 }
 
-transport_catalogue_proto::Stop Stop(uint64_t id, const domain::Stop& stop, const std::deque<domain::Bus>& buses,
-		const transport_catalogue::TransportCatalogue& db) {
+transport_catalogue_proto::Stop Stop(const domain::Stop& stop,
+		const transport_catalogue::TransportCatalogue& db, detail::NamesBlob& names) {
 	transport_catalogue_proto::Stop proto_stop;
 
-	proto_stop.set_id(id);
-	proto_stop.set_name(stop.name);
+	proto_stop.set_id(stop.id);
+	*proto_stop.mutable_name_handle() = names.Add(stop.name);
 	*proto_stop.mutable_coordinates() = std::move(make::Coordinates(stop));
 
-	const auto& buses_by_stop = db.GetStopInfo(&stop);
-	for (const auto bus_ptr : buses_by_stop) {
-		proto_stop.add_bus_id(detail::GetBusId(bus_ptr->name, buses));
+	const auto& bus_ids = db.GetBusIdsByStop(stop.id);
+	for (const auto bus_id : bus_ids) {
+		proto_stop.add_bus_id(bus_id);
 	}
+	*proto_stop.mutable_bus_posting() = {bus_ids.begin(), bus_ids.end()};
+	std::sort(proto_stop.mutable_bus_posting()->begin(), proto_stop.mutable_bus_posting()->end());
 
 	return proto_stop;
 }
 
-transport_catalogue_proto::Bus Bus(uint64_t id, const domain::Bus& bus, const std::deque<domain::Stop>& stops,
-		const transport_catalogue::TransportCatalogue& db) {
+transport_catalogue_proto::StopIndex StopIndex(const geo::Grid::Layout& layout) {
+	transport_catalogue_proto::StopIndex result;
+	result.mutable_min()->set_lat(layout.min.lat);
+	result.mutable_min()->set_lng(layout.min.lng);
+	result.set_cell_lat(layout.cell_lat);
+	result.set_cell_lng(layout.cell_lng);
+	result.set_rows(layout.rows);
+	result.set_cols(layout.cols);
+	*result.mutable_cell_begin() = {layout.cell_begin.begin(), layout.cell_begin.end()};
+	*result.mutable_stop_id() = {layout.ids.begin(), layout.ids.end()};
+	return result;
+}
+
+transport_catalogue_proto::Bus Bus(const domain::Bus& bus,
+		const transport_catalogue::TransportCatalogue& db, detail::NamesBlob& names) {
 	transport_catalogue_proto::Bus proto_bus;
 
 	const auto& bus_info = db.GetRouteInfo(&bus);
-	proto_bus.set_id(id);
-	proto_bus.set_name(bus.name);
+	proto_bus.set_id(bus.id);
+	*proto_bus.mutable_name_handle() = names.Add(bus.name);
 	proto_bus.set_is_circle(bus.is_circle);
 
-	for (const auto& stop_ptr : bus.route) {
-		proto_bus.add_stop_id(detail::GetStopId(stop_ptr->name, stops));
+	const domain::StopId* stop_ids = bus.route.GetStopIds();
+	for (size_t i = 0; i < bus.route.size(); ++i) {
+		proto_bus.add_stop_id(stop_ids[i]);
 	}
 
 	proto_bus.set_curvature(bus_info.curvature);
@@ -122,6 +157,34 @@ transport_catalogue_proto::Bus Bus(uint64_t id, const domain::Bus& bus, const st
 	proto_bus.set_stop_count(bus_info.stop_count);
 	proto_bus.set_unique_stop_count(bus_info.unique_stop_count);
 
+	const auto distances = db.GetRouteDistances(bus.id);
+	proto_bus.mutable_road_distance_prefix()->Reserve(distances.size());
+	proto_bus.mutable_geo_distance_prefix()->Reserve(distances.size());
+	for (size_t i = 0; i < distances.size(); ++i) {
+		proto_bus.add_road_distance_prefix(distances.GetRoadDistance(0, i));
+		proto_bus.add_geo_distance_prefix(distances.GetGeoDistance(0, i));
+	}
+
+	// пары {остановка, позиция} пути маршрута; обратное направление проходит
+	// остановки прямого в обратном порядке
+	const size_t size = bus.route.size();
+	std::vector<std::pair<domain::StopId, uint32_t>> positions;
+	positions.reserve(distances.size());
+	for (size_t position = 0; position < distances.size(); ++position) {
+		const size_t index = position < size ? position : 2 * size - 2 - position;
+		positions.emplace_back(stop_ids[index], static_cast<uint32_t>(position));
+	}
+	std::sort(positions.begin(), positions.end());
+	for (size_t i = 0; i < positions.size(); ++i) {
+		if (i == 0 || positions[i].first != positions[i - 1].first) {
+			proto_bus.add_position_stop_id(positions[i].first);
+			proto_bus.add_first_position(positions[i].second);
+			proto_bus.add_last_position(positions[i].second);
+		} else {
+			proto_bus.mutable_last_position()->Set(proto_bus.last_position_size() - 1, positions[i].second);
+		}
+	}
+
 	return proto_bus;
 }
 
@@ -201,6 +264,8 @@ transport_router_proto::RoutingSettings RoutingSettings(
 	transport_router_proto::RoutingSettings result;
 	result.set_bus_wait_time(settings.bus_wait_time);
 	result.set_bus_velocity(settings.bus_velocity);
+	result.set_walking_radius(settings.walking_radius);
+	result.set_walking_velocity(settings.walking_velocity);
 	return result;
 
 }
@@ -224,8 +289,8 @@ graph_proto::DirectedWeightedGraph Graph(const graph::DirectedWeightedGraph<tran
 	return result;
 }
 
-graph_proto::RouteInternalData RouteInternalData(
-		const std::optional<graph::Router<transport_router::Minutes>::RouteInternalData>& route) {
+template <typename RouteInternalDataType>
+graph_proto::RouteInternalData RouteInternalData(const std::optional<RouteInternalDataType>& route) {
 	graph_proto::RouteInternalData result;
 	if (route.has_value()) {
 		result.set_has_data(true);
@@ -242,8 +307,8 @@ graph_proto::RouteInternalData RouteInternalData(
 	return result;
 }
 
-graph_proto::RoutesInternalData RoutesInternalData(
-		const std::vector<std::optional<graph::Router<transport_router::Minutes>::RouteInternalData>>& routes) {
+template <typename RouteInternalDataType>
+graph_proto::RoutesInternalData RoutesInternalData(const std::vector<std::optional<RouteInternalDataType>>& routes) {
 	graph_proto::RoutesInternalData result;
 	for (const auto& route : routes) {
 		*result.add_route_internal_data() = std::move(make::RouteInternalData(route));
@@ -251,7 +316,9 @@ graph_proto::RoutesInternalData RoutesInternalData(
 	return result;
 }
 
-graph_proto::Router Router(const graph::Router<transport_router::Minutes>& router) {
+// router — graph::Router любой ширины номеров рёбер
+template <typename RouterType>
+graph_proto::Router Router(const RouterType& router) {
 	graph_proto::Router result;
 	for (const auto& routes : router.GetRoutesInternalDataRange()) {
 		*result.add_routes_internal_data() = std::move(make::RoutesInternalData(routes));
@@ -267,43 +334,44 @@ transport_router_proto::StopPairVertexId StopPairVertexId(const transport_router
 }
 
 void SetStopIdToPairVertexId(transport_router_proto::TransportRouter& transport_router,
-		const std::unordered_map<domain::StopPtr, transport_router::StopPairVertexId>& source,
-		const transport_catalogue::TransportCatalogue& transport_catalogue) {
-	const auto& stops = transport_catalogue.GetStops();
+		const std::vector<transport_router::StopPairVertexId>& source) {
 	auto& destination = *transport_router.mutable_stop_id_to_pair_vertex_id();
 
-	for (const auto& [stop_ptr, vertex_ids] : source) {
-		const uint64_t stop_id = detail::GetStopId(stop_ptr->name, stops);
-		destination[stop_id] = std::move(make::StopPairVertexId(vertex_ids));
+	for (size_t stop_id = 0; stop_id < source.size(); ++stop_id) {
+		destination[stop_id] = std::move(make::StopPairVertexId(source[stop_id]));
 	}
 }
 
 void SetEdgeIdToEdgeInfo(transport_router_proto::TransportRouter& transport_router,
-		const std::unordered_map<graph::EdgeId, transport_router::EdgeInfo>& source,
-		const transport_catalogue::TransportCatalogue& transport_catalogue) {
+		const std::vector<transport_router::EdgeInfo>& source) {
 	auto& destination = *transport_router.mutable_edge_id_to_edge_info();
 
-	for (const auto& [edge_id, edge_info] : source) {
-		destination[edge_id] = std::move(std::visit(detail::EdgeInfoGetter{transport_catalogue}, edge_info)); // make::EdgeInfo(edge_info, transport_catalogue)
+	for (size_t edge_id = 0; edge_id < source.size(); ++edge_id) {
+		destination[edge_id] = std::move(std::visit(detail::EdgeInfoGetter{}, source[edge_id]));
 	}
 
 }
 
-transport_router_proto::WaitEdgeInfo WaitEdgeInfo(const transport_router::WaitEdgeInfo& edge_info,
-		const std::deque<domain::Stop>& stops) {
+transport_router_proto::WaitEdgeInfo WaitEdgeInfo(const transport_router::WaitEdgeInfo& edge_info) {
 	transport_router_proto::WaitEdgeInfo result;
-	result.set_stop_id(detail::GetStopId(edge_info.stop_name, stops));
+	result.set_stop_id(edge_info.stop->id);
 	result.set_minutes(edge_info.time);
 	return result;
 }
-transport_router_proto::BusEdgeInfo BusEdgeInfo(const transport_router::BusEdgeInfo& edge_info,
-		const std::deque<domain::Bus>& buses) {
+transport_router_proto::BusEdgeInfo BusEdgeInfo(const transport_router::BusEdgeInfo& edge_info) {
 	transport_router_proto::BusEdgeInfo result;
-	result.set_bus_id(detail::GetBusId(edge_info.bus_name, buses));
+	result.set_bus_id(edge_info.bus->id);
 	result.set_span_count(edge_info.span_count);
 	result.set_minutes(edge_info.time);
 	return result;
 }
+transport_router_proto::WalkEdgeInfo WalkEdgeInfo(const transport_router::WalkEdgeInfo& edge_info) {
+	transport_router_proto::WalkEdgeInfo result;
+	result.set_from_stop_id(edge_info.from->id);
+	result.set_to_stop_id(edge_info.to->id);
+	result.set_minutes(edge_info.time);
+	return result;
+}
 
 }  // namespace make
 
@@ -311,23 +379,21 @@ namespace add {
 
 void Stops(
 		const transport_catalogue::TransportCatalogue& db,
-		transport_catalogue_proto::TransportCatalogue& transport_catalogue) {
+		transport_catalogue_proto::TransportCatalogue& transport_catalogue,
+		detail::NamesBlob& names) {
 
-	const auto& stops = db.GetStops();
-	const auto& buses = db.GetBuses();
-	for (size_t i = 0; i < stops.size(); ++i) {
-		*transport_catalogue.add_stop() = std::move(make::Stop(i, stops[i], buses, db));
+	for (const auto& stop : db.GetStops()) {
+		*transport_catalogue.add_stop() = std::move(make::Stop(stop, db, names));
 	}
 }
 
 void Buses(
 		const transport_catalogue::TransportCatalogue& db,
-		transport_catalogue_proto::TransportCatalogue& transport_catalogue) {
+		transport_catalogue_proto::TransportCatalogue& transport_catalogue,
+		detail::NamesBlob& names) {
 
-	const auto& stops = db.GetStops();
-	const auto& buses = db.GetBuses();
-	for (size_t i = 0; i < buses.size(); ++i) {
-		*transport_catalogue.add_bus() = std::move(make::Bus(i, buses[i], stops, db));
+	for (const auto& bus : db.GetBuses()) {
+		*transport_catalogue.add_bus() = std::move(make::Bus(bus, db, names));
 	}
 }
 
@@ -336,8 +402,7 @@ void Polylines(map_renderer_proto::MapRenderer& map_renderer,
 		const transport_catalogue::TransportCatalogue& transport_catalogue) {
 	const auto& buses = transport_catalogue.GetAllBusesSortedByName();
 	for (const auto bus_ptr : buses) {
-		uint64_t bus_id = detail::GetBusId(bus_ptr->name, transport_catalogue.GetBuses());
-		*map_renderer.add_polyline() = std::move(make::Polyline(bus_ptr, bus_id, projector));
+		*map_renderer.add_polyline() = std::move(make::Polyline(bus_ptr, bus_ptr->id, projector));
 	}
 }
 
@@ -346,8 +411,7 @@ void Circles(map_renderer_proto::MapRenderer& map_renderer,
 		const transport_catalogue::TransportCatalogue& transport_catalogue) {
 	const auto& stops = transport_catalogue.GetNonEmptyStopsSortedByName();
 	for (const auto stop_ptr : stops) {
-		uint64_t stop_id = detail::GetStopId(stop_ptr->name, transport_catalogue.GetStops());
-		*map_renderer.add_circle() = std::move(make::Circle(stop_ptr, stop_id, projector));
+		*map_renderer.add_circle() = std::move(make::Circle(stop_ptr, stop_ptr->id, projector));
 	}
 }
 
@@ -358,8 +422,22 @@ transport_catalogue_proto::TransportCatalogue SaveTransportCatalogue(
 		) {
 	transport_catalogue_proto::TransportCatalogue transport_catalogue;
 
-	add::Stops(db, transport_catalogue);
-	add::Buses(db, transport_catalogue);
+	detail::NamesBlob names;
+	add::Stops(db, transport_catalogue, names);
+	add::Buses(db, transport_catalogue, names);
+	transport_catalogue.set_names(names.Release());
+
+	std::vector<geo::Coordinates> coordinates;
+	std::vector<std::string_view> stop_names;
+	coordinates.reserve(db.StopsAmount());
+	stop_names.reserve(db.StopsAmount());
+	for (const auto& stop : db.GetStops()) {
+		coordinates.push_back(stop.coordinates);
+		stop_names.push_back(stop.name);
+	}
+	*transport_catalogue.mutable_stop_index() = std::move(make::StopIndex(geo::Grid(coordinates).GetLayout()));
+	const auto stop_order = NameSearchIndex::MakeOrder(stop_names);
+	*transport_catalogue.mutable_stop_id_by_name() = {stop_order.begin(), stop_order.end()};
 
 	return transport_catalogue;
 }
@@ -384,18 +462,21 @@ map_renderer_proto::MapRenderer SaveMapRenderer(
 	return map_renderer_proto;
 }
 
-transport_router_proto::TransportRouter SaveTransportRouter(
-		const transport_router::TransportRouter& transport_router,
-		const transport_catalogue::TransportCatalogue& transport_catalogue
-		) {
+transport_router_proto::TransportRouter SaveTransportRouter(const transport_router::TransportRouter& transport_router) {
 	transport_router_proto::TransportRouter transport_router_proto;
 
-	const auto& stops = transport_catalogue.GetStops();
 	*transport_router_proto.mutable_routing_settings() = std::move(make::RoutingSettings(transport_router.GetRoutingSettings()));
 	*transport_router_proto.mutable_graph() = std::move(make::Graph(transport_router.GetGraph()));
-	*transport_router_proto.mutable_router() = std::move(make::Router(transport_router.GetRouter()));
-	make::SetStopIdToPairVertexId(transport_router_proto, transport_router.GetStopToVertexIds(), transport_catalogue);
-	make::SetEdgeIdToEdgeInfo(transport_router_proto, transport_router.GetEdgeIdToEdgeInfo(), transport_catalogue);
+	transport_router_proto.set_engine(transport_router.GetEngine() == transport_router::RoutingEngine::SEARCH
+			? transport_router_proto::SEARCH
+			: transport_router_proto::TABLE);
+	if (transport_router.HasRouter()) {
+		transport_router.GetRouter().Visit([&transport_router_proto](const auto& router) {
+			*transport_router_proto.mutable_router() = make::Router(router);
+		});
+	}
+	make::SetStopIdToPairVertexId(transport_router_proto, transport_router.GetStopToVertexIds());
+	make::SetEdgeIdToEdgeInfo(transport_router_proto, transport_router.GetEdgeIdToEdgeInfo());
 
 	return transport_router_proto;
 }
@@ -414,9 +495,9 @@ void DataBaseSerializer::SetMapRenderer(const renderer::RenderSettings& render_s
 		const transport_catalogue::TransportCatalogue& transport_catalogue) {
 	*db_.mutable_map_renderer() = std::move(SaveMapRenderer(render_settings, transport_catalogue));
 }
-void DataBaseSerializer::SetTransportRouter(const transport_router::TransportRouter& transport_router,
-		const transport_catalogue::TransportCatalogue& transport_catalogue) {
-	*db_.mutable_transport_router() = std::move(SaveTransportRouter(transport_router, transport_catalogue));
+void DataBaseSerializer::SetTransportRouter(const transport_router::TransportRouter& transport_router) {
+	*db_.mutable_transport_router() = SaveTransportRouter(transport_router);
+	db_.mutable_header()->set_index_width(static_cast<uint32_t>(transport_router.GetIndexWidth()));
 }
 void DataBaseSerializer::Serialize() const {
 	std::ofstream file(file_name_, std::ios::binary);
@@ -1,4 +1,7 @@
+#pragma once
+
 #include <iostream>
+#include <string_view>
 
 #include <transport_catalogue.pb.h>
 #include <svg.pb.h>
@@ -12,6 +15,15 @@
 
 namespace transport_catalogue::serialization {
 
+// Название остановки или маршрута базы. Ссылается на общий блок названий
+// transport_catalogue.names() и действительно, пока база не изменена
+template <typename StopOrBus>
+std::string_view GetName(const transport_catalogue_proto::TransportCatalogue& transport_catalogue,
+		const StopOrBus& stop_or_bus) {
+	const auto& handle = stop_or_bus.name_handle();
+	return std::string_view(transport_catalogue.names()).substr(handle.offset(), handle.length());
+}
+
 class DataBaseSerializer {
 public:
 	DataBaseSerializer() = default;
@@ -19,8 +31,7 @@ public:
 	void SetTransportCatalogue(const transport_catalogue::TransportCatalogue& transport_catalogue);
 	void SetMapRenderer(const renderer::RenderSettings& render_settings,
 			const transport_catalogue::TransportCatalogue& transport_catalogue);
-	void SetTransportRouter(const transport_router::TransportRouter& transport_router,
-			const transport_catalogue::TransportCatalogue& transport_catalogue);
+	void SetTransportRouter(const transport_router::TransportRouter& transport_router);
 	void Serialize() const;
 
 private:
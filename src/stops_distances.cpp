@@ -0,0 +1,113 @@
+#include "stops_distances.h"
+
+#include <utility>
+
+namespace transport_catalogue {
+
+namespace {
+
+const size_t INITIAL_CAPACITY = 16;
+
+}  // namespace
+
+void StopsDistances::Set(domain::StopId from, domain::StopId to, uint64_t distance) {
+	const auto [forward, forward_inserted] = Emplace(MakeKey(from, to));
+	if (forward_inserted || forward->is_reverse) {
+		++explicit_count_;
+	}
+	forward->distance = distance;
+	forward->is_reverse = false;
+
+	if (from == to) {
+		return;
+	}
+	// явно заданное обратное расстояние не перезаписываем
+	const auto [reverse, reverse_inserted] = Emplace(MakeKey(to, from));
+	if (reverse_inserted || reverse->is_reverse) {
+		reverse->distance = distance;
+		reverse->is_reverse = true;
+	}
+}
+
+uint64_t StopsDistances::Find(domain::StopId from, domain::StopId to) const {
+	if (entries_.empty()) {
+		return 0;
+	}
+	// пустая ячейка хранит нулевое расстояние
+	return entries_[Probe(MakeKey(from, to))].distance;
+}
+
+size_t StopsDistances::Size() const {
+	return explicit_count_;
+}
+
+memory_usage::Item StopsDistances::MemoryUsage() const {
+	memory_usage::Item item = memory_usage::OfVector("stops_distances", entries_);
+	item.size = occupied_;
+	return item;
+}
+
+uint64_t StopsDistances::MakeKey(domain::StopId from, domain::StopId to) {
+	return (static_cast<uint64_t>(from) << 32) | to;
+}
+
+// финальное перемешивание splitmix64: соседние номера остановок
+// расходятся по всей таблице
+uint64_t StopsDistances::Mix(uint64_t key) {
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9ULL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebULL;
+	key ^= key >> 31;
+	return key;
+}
+
+size_t StopsDistances::Probe(uint64_t key) const {
+	const size_t mask = entries_.size() - 1;
+	size_t index = Mix(key) & mask;
+	while (entries_[index].key != key && entries_[index].key != EMPTY_KEY) {
+		index = (index + 1) & mask;
+	}
+	return index;
+}
+
+std::pair<StopsDistances::Entry*, bool> StopsDistances::Emplace(uint64_t key) {
+	// заполненность держим не выше 1/2, чтобы цепочки проб оставались короткими
+	if (2 * (occupied_ + 1) > entries_.size()) {
+		Grow();
+	}
+	Entry& entry = entries_[Probe(key)];
+	if (entry.key == key) {
+		return {&entry, false};
+	}
+	entry.key = key;
+	++occupied_;
+	return {&entry, true};
+}
+
+void StopsDistances::Reserve(size_t count) {
+	// каждый вызов Set добавляет не больше двух записей
+	size_t capacity = INITIAL_CAPACITY;
+	while (capacity < 4 * count) {
+		capacity *= 2;
+	}
+	if (capacity > entries_.size()) {
+		Rehash(capacity);
+	}
+}
+
+void StopsDistances::Grow() {
+	Rehash(entries_.empty() ? INITIAL_CAPACITY : 2 * entries_.size());
+}
+
+void StopsDistances::Rehash(size_t capacity) {
+	std::vector<Entry> old_entries(capacity);
+	std::swap(entries_, old_entries);
+	for (const auto& entry : old_entries) {
+		if (entry.key != EMPTY_KEY) {
+			entries_[Probe(entry.key)] = entry;
+		}
+	}
+}
+
+}  // namespace transport_catalogue
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "domain.h"
+#include "memory_usage.h"
+
+namespace transport_catalogue {
+
+// Таблица дорожных расстояний между остановками с открытой адресацией.
+// Ключ — пара номеров остановок, упакованная в 64 бита. Для каждого заданного
+// расстояния A -> B заранее заводится и обратная запись B -> A с пометкой
+// is_reverse, поэтому поиск с учётом обратного направления — одна проба.
+class StopsDistances {
+public:
+	// задаёт расстояние from -> to; если для to -> from расстояние не задано явно,
+	// оно тоже считается равным distance
+	void Set(domain::StopId from, domain::StopId to, uint64_t distance);
+
+	// готовит таблицу к count вызовам Set без перестроений
+	void Reserve(size_t count);
+
+	// расстояние from -> to, при его отсутствии to -> from, иначе 0
+	uint64_t Find(domain::StopId from, domain::StopId to) const;
+
+	// количество явно заданных расстояний
+	size_t Size() const;
+
+	// size — занятые ячейки, включая обратные записи
+	memory_usage::Item MemoryUsage() const;
+
+private:
+	struct Entry {
+		uint64_t key = EMPTY_KEY;
+		uint64_t distance = 0;
+		bool is_reverse = false;
+	};
+
+	// номера остановок меньше 2^32 - 1, поэтому такой ключ не встречается
+	static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+
+	std::vector<Entry> entries_; // размер — степень двойки
+	size_t occupied_ = 0;
+	size_t explicit_count_ = 0;
+
+	static uint64_t MakeKey(domain::StopId from, domain::StopId to);
+	static uint64_t Mix(uint64_t key);
+
+	// ячейка с ключом key либо пустая ячейка, куда его следует записать
+	size_t Probe(uint64_t key) const;
+	// возвращает ячейку с ключом key и признак того, что она только что создана
+	std::pair<Entry*, bool> Emplace(uint64_t key);
+	void Grow();
+	void Rehash(size_t capacity);
+};
+
+}  // namespace transport_catalogue
@@ -114,6 +114,11 @@ Polyline& Polyline::AddPoint(Point point) {
 	return *this;
 }
 
+void Circle::AddMemoryUsage(memory_usage::Item& item) const {
+	item.bytes += sizeof(Circle);
+	AddAttrsMemoryUsage(item);
+}
+
 void Polyline::RenderObject(const RenderContext& context) const {
 	// <polyline points="0,100 50,25 50,75 100,0" />
 	auto& out = context.out;
@@ -173,6 +178,13 @@ Text& Text::SetData(std::string data) {
 	return *this;
 }
 
+void Polyline::AddMemoryUsage(memory_usage::Item& item) const {
+	const auto points = memory_usage::OfDeque("points", points_);
+	item.bytes += sizeof(Polyline) + points.bytes;
+	item.allocations += points.allocations;
+	AddAttrsMemoryUsage(item);
+}
+
 void Text::RenderObject(const RenderContext& context) const {
 // <text x="35" y="20" dx="0" dy="6" font-size="12" font-family="Verdana" font-weight="bold">Hello C++</text>
 	auto& out = context.out;
@@ -212,6 +224,18 @@ void Text::RenderObject(const RenderContext& context) const {
 	out << "</text>"sv;
 }
 
+void Text::AddMemoryUsage(memory_usage::Item& item) const {
+	item.bytes += sizeof(Text);
+	if (font_family_) {
+		memory_usage::AddString(item, *font_family_);
+	}
+	if (font_weight_) {
+		memory_usage::AddString(item, *font_weight_);
+	}
+	memory_usage::AddString(item, data_);
+	AddAttrsMemoryUsage(item);
+}
+
 // ---------- Document ----------------
 
 // Добавляет в svg-документ объект-наследник svg::Object
@@ -229,4 +253,17 @@ void Document::Render(std::ostream& out) const {
 	out << "</svg>"sv;
 }
 
+memory_usage::Item Document::MemoryUsage() const {
+	// объекты созданы make_shared: объект и счётчик ссылок в одном блоке
+	const size_t CONTROL_BLOCK_SIZE = 2 * sizeof(void*);
+
+	memory_usage::Item item = memory_usage::OfDeque("objects", objects_);
+	for (const auto& obj : objects_) {
+		item.bytes += CONTROL_BLOCK_SIZE;
+		++item.allocations;
+		obj->AddMemoryUsage(item);
+	}
+	return item;
+}
+
 }  // namespace svg
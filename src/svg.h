@@ -8,6 +8,8 @@
 #include <string>
 #include <variant>
 
+#include "memory_usage.h"
+
 namespace svg {
 
 // ----------- Rgb --------------------
@@ -107,6 +109,15 @@ public:
 protected:
 	~PathProps() = default;
 
+	// память, выделенная под названия цветов
+	void AddAttrsMemoryUsage(memory_usage::Item& item) const {
+		for (const auto* color : {&fill_color_, &stroke_color_}) {
+			if (*color && std::holds_alternative<std::string>(**color)) {
+				memory_usage::AddString(item, std::get<std::string>(**color));
+			}
+		}
+	}
+
 	void RenderAttrs(std::ostream& out) const {
 		using namespace std::literals;
 
@@ -203,6 +214,9 @@ class Object {
 public:
 	void Render(const RenderContext& context) const;
 
+	// добавляет к item память объекта и принадлежащих ему строк и контейнеров
+	virtual void AddMemoryUsage(memory_usage::Item& item) const = 0;
+
 	virtual ~Object() = default;
 
 private:
@@ -218,6 +232,8 @@ public:
 	Circle& SetCenter(Point center);
 	Circle& SetRadius(double radius);
 
+	void AddMemoryUsage(memory_usage::Item& item) const override;
+
 private:
 	void RenderObject(const RenderContext& context) const override;
 
@@ -234,6 +250,8 @@ public:
 	// Добавляет очередную вершину к ломаной линии
 	Polyline& AddPoint(Point point);
 
+	void AddMemoryUsage(memory_usage::Item& item) const override;
+
 private:
 	void RenderObject(const RenderContext& context) const override;
 
@@ -264,6 +282,8 @@ public:
 	// Задаёт текстовое содержимое объекта (отображается внутри тега text)
 	Text& SetData(std::string data);
 
+	void AddMemoryUsage(memory_usage::Item& item) const override;
+
 private:
 	void RenderObject(const RenderContext& context) const override;
 
@@ -307,6 +327,9 @@ public:
 	// Выводит в ostream svg-представление документа
 	void Render(std::ostream& out) const;
 
+	// size — количество объектов документа
+	memory_usage::Item MemoryUsage() const;
+
 private:
 	std::deque<std::shared_ptr<Object>> objects_;
 };
@@ -0,0 +1,115 @@
+// Проверяет ComputeDistances обоими ядрами и ComputeHaversineDistance
+// по ComputeDistance от координат
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
+
+#include "../geo.h"
+
+namespace {
+
+// acos в ComputeDistance теряет точность на малых расстояниях — до десятков сантиметров
+const double ABSOLUTE_TOLERANCE = 0.5; // м
+const double RELATIVE_TOLERANCE = 1e-9;
+// ядра считают одни и те же хорды, арксинусы у них расходятся не больше чем на ulp
+const double KERNELS_TOLERANCE = 1e-6; // м
+
+int failures = 0;
+
+void Check(bool condition, std::string_view message, size_t index, double expected, double actual) {
+	if (!condition) {
+		++failures;
+		std::cerr.precision(17);
+		std::cerr << message << " at " << index << ": expected " << expected << ", got " << actual << '\n';
+	}
+}
+
+struct Points {
+	std::vector<geo::Coordinates> from;
+	std::vector<geo::Coordinates> to;
+};
+
+// пары точек: близкие, на расстоянии города и по всему земному шару
+Points GeneratePoints(size_t count) {
+	std::mt19937_64 random(42);
+	std::uniform_real_distribution<double> random_latitude(-89., 89.);
+	std::uniform_real_distribution<double> random_longitude(-180., 180.);
+	std::uniform_real_distribution<double> random_offset(-1., 1.);
+
+	Points points;
+	for (size_t i = 0; i < count; ++i) {
+		const geo::Coordinates from{random_latitude(random), random_longitude(random)};
+		const double scale = i % 3 == 0 ? 1e-4 : i % 3 == 1 ? 0.1 : 90.;
+		geo::Coordinates to{from.lat + scale * random_offset(random), from.lng + scale * random_offset(random)};
+		to.lat = std::fmax(-90., std::fmin(90., to.lat));
+		points.from.push_back(from);
+		points.to.push_back(to);
+	}
+	// совпадающие точки
+	points.from.push_back({55.6, 37.6});
+	points.to.push_back({55.6, 37.6});
+	return points;
+}
+
+std::vector<double> Compute(const Points& points, geo::DistanceKernel kernel) {
+	const size_t count = points.from.size();
+	geo::UnitVectors from(count);
+	geo::UnitVectors to(count);
+	for (size_t i = 0; i < count; ++i) {
+		from.Set(i, geo::ToUnitVector(points.from[i]));
+		to.Set(i, geo::ToUnitVector(points.to[i]));
+	}
+	std::vector<double> distances(count);
+	geo::ComputeDistances(from.View(), to.View(), count, distances.data(), kernel);
+	return distances;
+}
+
+void TestKernel(const Points& points, geo::DistanceKernel kernel, std::string_view name) {
+	const auto distances = Compute(points, kernel);
+	for (size_t i = 0; i < distances.size(); ++i) {
+		const double expected = geo::ComputeDistance(points.from[i], points.to[i]);
+		Check(std::abs(distances[i] - expected) <= ABSOLUTE_TOLERANCE + RELATIVE_TOLERANCE * expected,
+				name, i, expected, distances[i]);
+	}
+}
+
+void TestHaversine(const Points& points) {
+	for (size_t i = 0; i < points.from.size(); ++i) {
+		const double expected = geo::ComputeDistance(points.from[i], points.to[i]);
+		const double actual = geo::ComputeHaversineDistance(points.from[i], points.to[i]);
+		Check(std::abs(actual - expected) <= ABSOLUTE_TOLERANCE + RELATIVE_TOLERANCE * expected,
+				"Haversine", i, expected, actual);
+	}
+}
+
+}  // namespace
+
+int main() {
+	// нечётное количество: AVX2-ядро досчитывает остаток по одной паре
+	const Points points = GeneratePoints(1001);
+
+	TestHaversine(points);
+	TestKernel(points, geo::DistanceKernel::SCALAR, "SCALAR");
+	if (geo::IsSupported(geo::DistanceKernel::AVX2)) {
+		TestKernel(points, geo::DistanceKernel::AVX2, "AVX2");
+
+		const auto scalar = Compute(points, geo::DistanceKernel::SCALAR);
+		const auto avx2 = Compute(points, geo::DistanceKernel::AVX2);
+		for (size_t i = 0; i < scalar.size(); ++i) {
+			Check(std::abs(scalar[i] - avx2[i]) <= KERNELS_TOLERANCE, "AVX2 vs SCALAR", i, scalar[i], avx2[i]);
+		}
+	} else {
+		std::cout << "AVX2 is not supported, only the scalar kernel is tested\n";
+	}
+
+	if (failures > 0) {
+		std::cerr << failures << " checks failed\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "geo_test passed\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,38 @@
+# Проверяет ответы process_requests на ошибочные запросы и на оборванный ввод.
+# PROGRAM — путь к transport_catalogue, DATA — каталог с входными данными
+
+function(run_program mode input output result)
+    execute_process(COMMAND ${PROGRAM} ${mode}
+                    INPUT_FILE ${input}
+                    OUTPUT_VARIABLE program_output
+                    RESULT_VARIABLE program_result
+                    ERROR_QUIET)
+    string(STRIP "${program_output}" program_output)
+    set(${output} "${program_output}" PARENT_SCOPE)
+    set(${result} "${program_result}" PARENT_SCOPE)
+endfunction()
+
+function(read_expected file_name expected)
+    file(READ ${DATA}/${file_name} content)
+    string(STRIP "${content}" content)
+    set(${expected} "${content}" PARENT_SCOPE)
+endfunction()
+
+run_program(make_base ${DATA}/errors_make_base.json output result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "make_base failed: ${result}")
+endif()
+
+# ошибочные запросы получают ответ с error_message, остальные выполняются
+run_program(process_requests ${DATA}/errors_process_requests.json output result)
+read_expected(errors_expected.json expected)
+if (NOT result EQUAL 0 OR NOT output STREQUAL expected)
+    message(FATAL_ERROR "Unexpected answers to invalid requests (${result}):\n${output}")
+endif()
+
+# ввод обрывается на шестом запросе: пять ответов выведены, массив закрыт, программа завершается ошибкой
+run_program(process_requests ${DATA}/truncated_process_requests.json output result)
+read_expected(truncated_expected.json expected)
+if (result EQUAL 0 OR NOT output STREQUAL expected)
+    message(FATAL_ERROR "Unexpected output on truncated input (${result}):\n${output}")
+endif()
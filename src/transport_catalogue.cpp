@@ -1,8 +1,12 @@
 #include <algorithm>
+#include <atomic>
 #include <deque>
 #include <exception>
+#include <limits>
+#include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <tuple>
 #include <vector>
 #include <unordered_map>
@@ -23,23 +27,79 @@ bool StartsWith(std::string_view source, std::string_view seek) {
 	return found == seek;
 }
 
+namespace {
+
+const size_t MIN_ITEMS_PER_THREAD = 4096;
+
+// делит [0, count) на непрерывные части и вызывает func(begin, end) для каждой в своём потоке
+template <typename Func>
+void ParallelFor(size_t count, Func func) {
+	const size_t hardware_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	const size_t thread_count = std::min(hardware_threads, count / MIN_ITEMS_PER_THREAD + 1);
+	if (thread_count == 1) {
+		func(size_t{0}, count);
+		return;
+	}
+	std::vector<std::thread> threads;
+	threads.reserve(thread_count - 1);
+	const size_t chunk = (count + thread_count - 1) / thread_count;
+	for (size_t begin = chunk; begin < count; begin += chunk) {
+		threads.emplace_back(func, begin, std::min(count, begin + chunk));
+	}
+	func(size_t{0}, std::min(count, chunk));
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+} // namespace
+
 } // namespace detail
 
 void TransportCatalogue::AddStop(domain::Stop stop) {
-	stops_.emplace_back(stop);
+	stop.id = static_cast<domain::StopId>(stops_.size());
+	stop.name = names_.Intern(stop.name);
+	stop_points_.push_back(geo::ToUnitVector(stop.coordinates));
+	stops_.emplace_back(std::move(stop));
 	stop_indexes_[stops_.back().name] = &stops_.back();
-	stop_to_buses_[&stops_.back()];
+	stop_to_buses_.emplace_back();
 }
 
-void TransportCatalogue::AddBus(domain::Bus bus) {
-	buses_.emplace_back(bus);
+void TransportCatalogue::AddBus(domain::BusDescription bus) {
+	const auto bus_id = static_cast<domain::BusId>(buses_.size());
+	const auto offset = static_cast<uint32_t>(route_stops_.size());
+	for (const auto stop_ptr : bus.route) {
+		route_stops_.push_back(stop_ptr->id);
+	}
 
-	const auto& stops = buses_.back().route;
-	for (const auto& stop_ptr : stops) {
-		stop_to_buses_.at(stop_ptr).push_back(&buses_.back());
+	buses_.push_back(domain::Bus{names_.Intern(bus.name), bus.is_circle,
+			domain::RouteView{&route_stops_, &stops_, offset, static_cast<uint32_t>(bus.route.size())},
+			bus_id});
+	const auto& added_bus = buses_.back();
+	bus_indexes_[added_bus.name] = &added_bus;
+	detail::InsertSortedByName(buses_by_name_, &added_bus);
+
+	// списки маршрутов остановок держим без повторов и упорядоченными по названию
+	for (const auto stop_ptr : added_bus.route) {
+		auto& stop_buses = stop_to_buses_[stop_ptr->id];
+		if (stop_buses.empty()) {
+			detail::InsertSortedByName(non_empty_stops_by_name_, stop_ptr);
+		}
+		const auto iter = std::lower_bound(stop_buses.begin(), stop_buses.end(), added_bus.name,
+				[this](domain::BusId lhs, std::string_view name) {
+					return buses_[lhs].name < name;
+				});
+		if (iter == stop_buses.end() || *iter != bus_id) {
+			stop_buses.insert(iter, bus_id);
+		}
 	}
 
-	bus_indexes_[buses_.back().name] = &buses_.back();
+	const size_t prefix_offset = road_prefixes_.size();
+	prefix_offsets_.push_back(static_cast<uint32_t>(prefix_offset));
+	road_prefixes_.resize(prefix_offset + GetPathLength(added_bus));
+	geo_prefixes_.resize(road_prefixes_.size());
+	ComputeRouteDistances(added_bus, road_prefixes_.data() + prefix_offset, geo_prefixes_.data() + prefix_offset);
+	bus_stats_.push_back(ComputeBusStat(added_bus, GetRouteDistances(bus_id)));
 }
 
 void TransportCatalogue::AddStopsDistances(const std::deque<domain::FromToDistance>& stops_distances) {
@@ -47,119 +107,274 @@ void TransportCatalogue::AddStopsDistances(const std::deque<domain::FromToDistan
 		auto from = FindStop(stops_distance.from);
 		auto to = FindStop(stops_distance.to);
 
-		stops_distances_[std::make_pair(from, to)] = stops_distance.distance;
+		stops_distances_.Set(from->id, to->id, stops_distance.distance);
+	}
+	if (!buses_.empty()) {
+		are_bus_stats_stale_ = true;
 	}
 }
 
-domain::BusStat TransportCatalogue::GetRouteInfo (domain::BusPtr bus) const {
-	domain::BusStat route_info;
-	route_info.stop_count = bus->is_circle ? bus->route.size() : 2 * bus->route.size() - 1;
-	{
-		std::unordered_set<std::string_view> unique_stops;
-		for (const auto stop_ptr : bus->route) {
-			unique_stops.insert(std::string_view(stop_ptr->name));
+void TransportCatalogue::Load(CatalogueData data) {
+	using namespace std::literals;
+
+	if (!stops_.empty() || !buses_.empty()) {
+		throw std::logic_error("Bulk load requires an empty catalogue");
+	}
+
+	// остановки и их названия
+	stop_indexes_.reserve(data.stops.size());
+	stop_to_buses_.resize(data.stops.size());
+	stop_points_.reserve(data.stops.size());
+	for (auto& stop : data.stops) {
+		stop.id = static_cast<domain::StopId>(stops_.size());
+		stop.name = names_.Intern(stop.name);
+		stop_points_.push_back(geo::ToUnitVector(stop.coordinates));
+		stops_.push_back(stop);
+		// как и AddStop, повторное описание остановки заменяет её в индексе названий
+		stop_indexes_[stops_.back().name] = &stops_.back();
+	}
+
+	// названия остановок в маршрутах и расстояниях переводятся в номера параллельно;
+	// в ошибках запоминается первая неизвестная остановка
+	constexpr size_t NO_ERROR = std::numeric_limits<size_t>::max();
+	const auto throw_unknown_stop = [](std::string_view name) {
+		throw std::invalid_argument("Unknown stop "s + std::string(name));
+	};
+
+	std::vector<std::vector<domain::StopId>> routes(data.buses.size());
+	std::atomic<size_t> route_error = NO_ERROR;
+	detail::ParallelFor(data.buses.size(), [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i) {
+			auto& route = routes[i];
+			route.reserve(data.buses[i].stop_names.size());
+			for (const auto stop_name : data.buses[i].stop_names) {
+				const auto stop = FindStop(stop_name);
+				if (!stop) {
+					size_t expected = NO_ERROR;
+					route_error.compare_exchange_strong(expected, i);
+					return;
+				}
+				route.push_back(stop->id);
+			}
+		}
+	});
+	if (route_error != NO_ERROR) {
+		for (const auto stop_name : data.buses[route_error].stop_names) {
+			if (!FindStop(stop_name)) {
+				throw_unknown_stop(stop_name);
+			}
 		}
-		route_info.unique_stop_count = unique_stops.size();
 	}
 
-	double straight_length = 0.;
-	route_info.route_length = bus->is_circle
-			? 0
-			: FindDistance(bus->route.back(), bus->route.back());
-	{
-		const auto& bus_route = bus->route;
-		const size_t size = bus_route.size();
-
-		for (size_t i = 1; i < size; ++i) {
-			const double distance = geo::ComputeDistance(bus_route[i]->coordinates,
-					bus_route[i - 1]->coordinates);
-			straight_length += bus->is_circle ? distance : 2. * distance;
-
-			route_info.route_length += bus->is_circle
-					? FindDistance(bus_route[i - 1], bus_route[i])
-					: (FindDistance(bus_route[i - 1], bus_route[i])
-							+ FindDistance(bus_route[i], bus_route[i - 1]));
+	std::vector<std::pair<domain::StopId, domain::StopId>> distance_ids(data.distances.size());
+	std::atomic<size_t> distance_error = NO_ERROR;
+	detail::ParallelFor(data.distances.size(), [&](size_t begin, size_t end) {
+		// расстояния от одной остановки обычно идут подряд
+		std::string_view last_from_name;
+		domain::StopPtr last_from = nullptr;
+		for (size_t i = begin; i < end; ++i) {
+			if (!last_from || data.distances[i].from != last_from_name) {
+				last_from_name = data.distances[i].from;
+				last_from = FindStop(last_from_name);
+			}
+			const auto from = last_from;
+			const auto to = FindStop(data.distances[i].to);
+			if (!from || !to) {
+				size_t expected = NO_ERROR;
+				distance_error.compare_exchange_strong(expected, i);
+				return;
+			}
+			distance_ids[i] = {from->id, to->id};
 		}
+	});
+	if (distance_error != NO_ERROR) {
+		const auto& distance = data.distances[distance_error];
+		throw_unknown_stop(FindStop(distance.from) ? distance.to : distance.from);
 	}
 
-	route_info.curvature = route_info.route_length / straight_length;
+	stops_distances_.Reserve(data.distances.size());
+	for (size_t i = 0; i < data.distances.size(); ++i) {
+		stops_distances_.Set(distance_ids[i].first, distance_ids[i].second, data.distances[i].distance);
+	}
 
-	return route_info;
-}
+	// маршруты
+	size_t route_stops_count = 0;
+	for (const auto& route : routes) {
+		route_stops_count += route.size();
+	}
+	route_stops_.reserve(route_stops_count);
+	bus_indexes_.reserve(data.buses.size());
+	for (size_t i = 0; i < data.buses.size(); ++i) {
+		const auto bus_id = static_cast<domain::BusId>(buses_.size());
+		const auto offset = static_cast<uint32_t>(route_stops_.size());
+		route_stops_.insert(route_stops_.end(), routes[i].begin(), routes[i].end());
+		buses_.push_back(domain::Bus{names_.Intern(data.buses[i].name), data.buses[i].is_circle,
+				domain::RouteView{&route_stops_, &stops_, offset, static_cast<uint32_t>(routes[i].size())},
+				bus_id});
+		bus_indexes_[buses_.back().name] = &buses_.back();
+		for (const auto stop_id : routes[i]) {
+			stop_to_buses_[stop_id].push_back(bus_id);
+		}
+	}
 
-std::unordered_set<domain::BusPtr> TransportCatalogue::GetStopInfo(domain::StopPtr stop) const {
-	const auto& buses = stop_to_buses_.at(stop);
+	// списки маршрутов остановок упорядочиваются, статистика маршрутов считается параллельно
+	detail::ParallelFor(stop_to_buses_.size(), [this](size_t begin, size_t end) {
+		for (size_t stop_id = begin; stop_id < end; ++stop_id) {
+			// номера добавлялись по возрастанию, повторы стоят рядом
+			auto& stop_buses = stop_to_buses_[stop_id];
+			stop_buses.erase(std::unique(stop_buses.begin(), stop_buses.end()), stop_buses.end());
+			std::sort(stop_buses.begin(), stop_buses.end(),
+					[this](domain::BusId lhs, domain::BusId rhs) {
+						return buses_[lhs].name < buses_[rhs].name;
+					});
+		}
+	});
 
-	std::unordered_set<domain::BusPtr> unsorted_buses;
-	for (const auto bus_ptr : buses) {
-		unsorted_buses.insert(bus_ptr);
+	buses_by_name_.reserve(buses_.size());
+	for (const auto& bus : buses_) {
+		buses_by_name_.push_back(&bus);
+	}
+	detail::SortByName(buses_by_name_);
+	for (const auto& stop : stops_) {
+		if (!stop_to_buses_[stop.id].empty()) {
+			non_empty_stops_by_name_.push_back(&stop);
+		}
 	}
+	detail::SortByName(non_empty_stops_by_name_);
 
-	return unsorted_buses;
+	size_t path_stops_count = 0;
+	prefix_offsets_.reserve(buses_.size());
+	for (const auto& bus : buses_) {
+		prefix_offsets_.push_back(static_cast<uint32_t>(path_stops_count));
+		path_stops_count += GetPathLength(bus);
+	}
+	road_prefixes_.resize(path_stops_count);
+	geo_prefixes_.resize(path_stops_count);
+
+	bus_stats_.resize(buses_.size());
+	detail::ParallelFor(buses_.size(), [this](size_t begin, size_t end) {
+		for (size_t bus_id = begin; bus_id < end; ++bus_id) {
+			const auto offset = prefix_offsets_[bus_id];
+			ComputeRouteDistances(buses_[bus_id], road_prefixes_.data() + offset, geo_prefixes_.data() + offset);
+			bus_stats_[bus_id] = ComputeBusStat(buses_[bus_id], GetRouteDistances(bus_id));
+		}
+	});
+	are_bus_stats_stale_ = false;
 }
 
-std::deque<std::string> TransportCatalogue::GetAllBusNames() const {
-	std::deque<std::string> result;
+void TransportCatalogue::Finalize() {
+	if (!are_bus_stats_stale_) {
+		return;
+	}
 	for (const auto& bus : buses_) {
-		result.push_back(bus.name);
+		const auto offset = prefix_offsets_[bus.id];
+		ComputeRouteDistances(bus, road_prefixes_.data() + offset, geo_prefixes_.data() + offset);
+		bus_stats_[bus.id] = ComputeBusStat(bus, GetRouteDistances(bus.id));
 	}
-	return result;
+	are_bus_stats_stale_ = false;
 }
 
-const std::deque<domain::Bus>& TransportCatalogue::GetBuses() const {
-	return buses_;
+domain::BusStat TransportCatalogue::GetRouteInfo (domain::BusPtr bus) const {
+	if (are_bus_stats_stale_) {
+		std::vector<uint64_t> road(GetPathLength(*bus));
+		std::vector<double> geo(road.size());
+		ComputeRouteDistances(*bus, road.data(), geo.data());
+		return ComputeBusStat(*bus, domain::RouteDistances{&road, &geo, 0, static_cast<uint32_t>(road.size())});
+	}
+	return bus_stats_[bus->id];
 }
 
-const std::deque<domain::Stop>& TransportCatalogue::GetStops() const {
-	return stops_;
+domain::RouteDistances TransportCatalogue::GetRouteDistances(domain::BusId id) const {
+	return domain::RouteDistances{&road_prefixes_, &geo_prefixes_, prefix_offsets_[id],
+			static_cast<uint32_t>(GetPathLength(buses_[id]))};
 }
 
-std::deque<domain::BusPtr> TransportCatalogue::GetBusPtrs() const {
-	std::deque<domain::BusPtr> result;
-	for (const auto& bus : buses_) {
-		result.push_back(&bus);
+size_t TransportCatalogue::GetPathLength(const domain::Bus& bus) {
+	if (bus.route.empty()) {
+		return 0;
 	}
-	return result;
+	return bus.is_circle ? bus.route.size() : 2 * bus.route.size() - 1;
 }
 
-std::deque<domain::StopPtr> TransportCatalogue::GetStopPtrs() const {
-	std::deque<domain::StopPtr> result;
-	for (const auto& stop : stops_) {
-		result.push_back(&stop);
+void TransportCatalogue::ComputeRouteDistances(const domain::Bus& bus, uint64_t* road, double* geo) const {
+	const auto& bus_route = bus.route;
+	const size_t size = bus_route.size();
+	if (size == 0) {
+		return;
 	}
-	return result;
-}
 
-const StopsDistances& TransportCatalogue::GetStopsDistances() const {
-	return stops_distances_;
+	// прямые расстояния всех перегонов маршрута считаются одним вызовом
+	geo::UnitVectors points(size);
+	const domain::StopId* stop_ids = bus_route.GetStopIds();
+	for (size_t i = 0; i < size; ++i) {
+		points.Set(i, stop_points_[stop_ids[i]]);
+	}
+	std::vector<double> straight_distances(size - 1);
+	geo::ComputeDistances(points.View(), points.View().Advanced(1), straight_distances.size(),
+			straight_distances.data());
+
+	road[0] = 0;
+	geo[0] = 0.;
+	for (size_t i = 1; i < size; ++i) {
+		road[i] = road[i - 1] + FindDistance(bus_route[i - 1], bus_route[i]);
+		geo[i] = geo[i - 1] + straight_distances[i - 1];
+	}
+	if (bus.is_circle) {
+		return;
+	}
+	// позиция size - 1 + k пути — остановка bus_route[size - 1 - k] на обратном направлении
+	for (size_t k = 1; k < size; ++k) {
+		const size_t position = size - 1 + k;
+		const size_t to = size - 1 - k;
+		road[position] = road[position - 1] + FindDistance(bus_route[to + 1], bus_route[to]);
+		geo[position] = geo[position - 1] + straight_distances[to];
+	}
 }
 
-std::deque<domain::BusPtr> TransportCatalogue::GetAllBusesSortedByName() const {
-	std::deque<domain::BusPtr> result;
-	for (const auto& bus : buses_) {
-		result.push_back(&bus);
+domain::BusStat TransportCatalogue::ComputeBusStat(const domain::Bus& bus,
+		domain::RouteDistances distances) const {
+	domain::BusStat route_info;
+	route_info.stop_count = bus.is_circle ? bus.route.size() : 2 * bus.route.size() - 1;
+	{
+		const domain::StopId* stop_ids = bus.route.GetStopIds();
+		std::vector<domain::StopId> unique_stops(stop_ids, stop_ids + bus.route.size());
+		std::sort(unique_stops.begin(), unique_stops.end());
+		route_info.unique_stop_count = std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin();
 	}
-	detail::SortByName(result);
-	return result;
-}
 
-std::deque<domain::StopPtr> TransportCatalogue::GetNonEmptyStopsSortedByName() const {
-	std::deque<domain::StopPtr> result;
-	for (const auto& stop : stops_) {
-		if (!stop_to_buses_.at(&stop).empty()) {
-			result.push_back(&stop);
+	double straight_length = 0.;
+	if (!distances.empty()) {
+		const size_t last = distances.size() - 1;
+		route_info.route_length = distances.GetRoadDistance(0, last);
+		if (!bus.is_circle) {
+			route_info.route_length += FindDistance(bus.route.back(), bus.route.back());
 		}
+		straight_length = distances.GetGeoDistance(0, last);
 	}
-	detail::SortByName(result);
-	return result;
+
+	route_info.curvature = route_info.route_length / straight_length;
+
+	return route_info;
 }
 
-std::deque<geo::Coordinates> TransportCatalogue::GetAllStopsCoordinates() const {
-	std::deque<geo::Coordinates> result;
-	for (const auto& stop : stops_) {
-		result.push_back(stop.coordinates);
-	}
-	return result;
+const std::deque<domain::Bus>& TransportCatalogue::GetBuses() const {
+	return buses_;
+}
+
+const std::deque<domain::Stop>& TransportCatalogue::GetStops() const {
+	return stops_;
+}
+
+const StopsDistances& TransportCatalogue::GetStopsDistances() const {
+	return stops_distances_;
+}
+
+const std::vector<domain::BusPtr>& TransportCatalogue::GetAllBusesSortedByName() const {
+	return buses_by_name_;
+}
+
+const std::vector<domain::StopPtr>& TransportCatalogue::GetNonEmptyStopsSortedByName() const {
+	return non_empty_stops_by_name_;
 }
 
 size_t TransportCatalogue::BusesAmount() const {
@@ -171,31 +386,58 @@ size_t TransportCatalogue::StopsAmount() const {
 }
 
 domain::StopPtr TransportCatalogue::FindStop (std::string_view stop_name) const {
-	if (stop_indexes_.count(stop_name)) {
-		return stop_indexes_.at(stop_name);
+	if (const auto iter = stop_indexes_.find(stop_name); iter != stop_indexes_.end()) {
+		return iter->second;
 	} else {
 		return nullptr;
 	}
 }
 
 domain::BusPtr TransportCatalogue::FindBus (std::string_view bus_name) const {
-	if (bus_indexes_.count(bus_name)) {
-		return bus_indexes_.at(bus_name);
+	if (const auto iter = bus_indexes_.find(bus_name); iter != bus_indexes_.end()) {
+		return iter->second;
 	} else {
 		return nullptr;
 	}
 }
 
+domain::StopPtr TransportCatalogue::GetStop(domain::StopId id) const {
+	return &stops_.at(id);
+}
+
+domain::BusPtr TransportCatalogue::GetBus(domain::BusId id) const {
+	return &buses_.at(id);
+}
+
+const std::vector<domain::BusId>& TransportCatalogue::GetBusIdsByStop(domain::StopId id) const {
+	return stop_to_buses_.at(id);
+}
+
 uint64_t TransportCatalogue::FindDistance(
 		domain::StopPtr start, domain::StopPtr destination) const {
-	if (const auto& stop_ptr_pair = std::make_pair(start, destination);
-			stops_distances_.count(stop_ptr_pair)) {
-		return stops_distances_.at(stop_ptr_pair);
-	} else if (const auto& stop_ptr_pair = std::make_pair(destination, start);
-			stops_distances_.count(stop_ptr_pair)) {
-		return stops_distances_.at(stop_ptr_pair);
-	}
-	return 0;
+	return stops_distances_.Find(start->id, destination->id);
+}
+
+memory_usage::Report TransportCatalogue::MemoryUsage() const {
+	using namespace memory_usage;
+
+	Report report;
+	report.Append("names", names_.MemoryUsage());
+	report.Add(OfDeque("buses", buses_));
+	report.Add(OfDeque("stops", stops_));
+	report.Add(OfVector("stop_points", stop_points_));
+	report.Add(OfVector("route_stops", route_stops_));
+	report.Add(OfHashContainer("bus_indexes", bus_indexes_));
+	report.Add(OfHashContainer("stop_indexes", stop_indexes_));
+	report.Add(OfNestedVector("stop_to_buses", stop_to_buses_));
+	report.Add(OfVector("buses_by_name", buses_by_name_));
+	report.Add(OfVector("non_empty_stops_by_name", non_empty_stops_by_name_));
+	report.Add(stops_distances_.MemoryUsage());
+	report.Add(OfVector("bus_stats", bus_stats_));
+	report.Add(OfVector("road_prefixes", road_prefixes_));
+	report.Add(OfVector("geo_prefixes", geo_prefixes_));
+	report.Add(OfVector("prefix_offsets", prefix_offsets_));
+	return report;
 }
 
 } // namespace transport_catalogue
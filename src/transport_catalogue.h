@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <deque>
 #include <set>
 #include <string>
@@ -11,66 +12,102 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "memory_usage.h"
+#include "name_arena.h"
+#include "stops_distances.h"
 
 namespace transport_catalogue {
 
 using Buses = std::deque<domain::Bus>;
-using Stops = std::deque<domain::Stop>;
-using StopsDistances = std::unordered_map<std::pair<domain::StopPtr, domain::StopPtr>,
-											uint64_t, domain::PairOfStopPtrHasher>;
+using Stops = domain::Stops;
 
 namespace detail {
 
 bool StartsWith(std::string_view source, std::string_view seek);
 
+template <typename Container>
+void SortByName(Container& container) {
+	std::sort(container.begin(), container.end(),
+			[](const auto& lhs, const auto& rhs) {
+				return lhs->name < rhs->name;
+			}
+	);
+}
+
+// вставляет item в упорядоченный по названию container, если его там ещё нет
 template <typename DomainPtr>
-void SortByName(std::deque<DomainPtr>& container) {
-	sort(container.begin(), container.end(),
+void InsertSortedByName(std::vector<DomainPtr>& container, DomainPtr item) {
+	const auto iter = std::lower_bound(container.begin(), container.end(), item,
 			[](const DomainPtr& lhs, const DomainPtr& rhs) {
 				return lhs->name < rhs->name;
 			}
 	);
+	if (iter == container.end() || *iter != item) {
+		container.insert(iter, item);
+	}
 }
 
 } // namespace detail
 
+// Всё содержимое справочника для загрузки одним вызовом
+struct CatalogueData {
+	std::vector<domain::Stop> stops;
+	std::vector<domain::FromToDistance> distances;
+	std::vector<domain::BusByStopNames> buses;
+};
+
 class TransportCatalogue {
 
 
 public:
 	explicit TransportCatalogue() = default;
+	// маршруты ссылаются на внутренние контейнеры справочника
+	TransportCatalogue(const TransportCatalogue&) = delete;
+	TransportCatalogue& operator=(const TransportCatalogue&) = delete;
 
 	void AddStop(domain::Stop stop);
 
-	void AddBus(domain::Bus bus);
+	void AddBus(domain::BusDescription bus);
 
 	void AddStopsDistances(const std::deque<domain::FromToDistance>& stops_distances);
 
+	// Загружает пустой справочник целиком: индексы создаются сразу нужного размера,
+	// ссылки на остановки проверяются за один проход, независимые этапы
+	// выполняются параллельно. При неизвестной остановке бросает std::invalid_argument
+	void Load(CatalogueData data);
+
+	// пересчитывает статистику маршрутов, если после их добавления менялись расстояния
+	void Finalize();
+
 	domain::StopPtr FindStop(std::string_view stop_name) const;
 
 	domain::BusPtr FindBus(std::string_view bus_name) const;
 
-	domain::BusStat GetRouteInfo(domain::BusPtr bus) const;
+	domain::StopPtr GetStop(domain::StopId id) const;
 
-	std::unordered_set<domain::BusPtr> GetStopInfo(domain::StopPtr stop) const;
+	domain::BusPtr GetBus(domain::BusId id) const;
 
-	std::deque<std::string> GetAllBusNames() const;
+	// номера маршрутов, проходящих через остановку, без повторов, упорядоченные по названию
+	const std::vector<domain::BusId>& GetBusIdsByStop(domain::StopId id) const;
 
-	const std::deque<domain::Bus>& GetBuses() const;
+	// статистика считается при добавлении маршрута, запрос — O(1)
+	domain::BusStat GetRouteInfo(domain::BusPtr bus) const;
 
-	const std::deque<domain::Stop>& GetStops() const;
+	// Накопленные расстояния вдоль пути маршрута. Считаются при добавлении маршрута;
+	// если после этого менялись расстояния, актуальны только после Finalize
+	domain::RouteDistances GetRouteDistances(domain::BusId id) const;
 
-	std::deque<domain::BusPtr> GetBusPtrs() const;
+	// маршруты и остановки в порядке номеров
+	const std::deque<domain::Bus>& GetBuses() const;
 
-	std::deque<domain::StopPtr> GetStopPtrs() const;
+	const std::deque<domain::Stop>& GetStops() const;
 
 	const StopsDistances& GetStopsDistances() const;
 
-	std::deque<domain::BusPtr> GetAllBusesSortedByName() const;
+	// упорядоченные по названию списки поддерживаются при добавлении маршрутов
+	const std::vector<domain::BusPtr>& GetAllBusesSortedByName() const;
 
-	std::deque<domain::StopPtr> GetNonEmptyStopsSortedByName() const;
-
-	std::deque<geo::Coordinates> GetAllStopsCoordinates() const;
+	const std::vector<domain::StopPtr>& GetNonEmptyStopsSortedByName() const;
 
 	size_t BusesAmount() const;
 
@@ -78,13 +115,33 @@ public:
 
 	uint64_t FindDistance(domain::StopPtr start, domain::StopPtr destination) const;
 
+	memory_usage::Report MemoryUsage() const;
+
 private:
-	Buses buses_; // хранит все маршруты
-	Stops stops_; // хранит все остановки
+	NameArena names_; // названия остановок и маршрутов
+	Buses buses_; // хранит все маршруты, индекс — BusId
+	Stops stops_; // хранит все остановки, индекс — StopId
+	std::vector<geo::UnitVector> stop_points_; // координаты остановок на единичной сфере, индекс — StopId
+	domain::RouteArena route_stops_; // остановки всех маршрутов подряд
 	std::unordered_map<std::string_view, domain::BusPtr> bus_indexes_; // для быстрого поиска автобуса
 	std::unordered_map<std::string_view, domain::StopPtr> stop_indexes_; // для быстрого поиска остановки
-	std::unordered_map<domain::StopPtr, std::deque<domain::BusPtr>> stop_to_buses_;
+	std::vector<std::vector<domain::BusId>> stop_to_buses_; // индекс — StopId
+	std::vector<domain::BusPtr> buses_by_name_;
+	std::vector<domain::StopPtr> non_empty_stops_by_name_; // остановки, через которые проходят маршруты
 	StopsDistances stops_distances_;
+	std::vector<domain::BusStat> bus_stats_; // индекс — BusId
+	std::vector<uint64_t> road_prefixes_; // накопленные расстояния путей всех маршрутов подряд
+	std::vector<double> geo_prefixes_;
+	std::vector<uint32_t> prefix_offsets_; // индекс — BusId
+	bool are_bus_stats_stale_ = false; // расстояния менялись после добавления маршрутов
+
+	// количество остановок полного пути маршрута, включая обратное направление
+	static size_t GetPathLength(const domain::Bus& bus);
+
+	// заполняет road и geo накопленными расстояниями пути маршрута, GetPathLength(bus) штук
+	void ComputeRouteDistances(const domain::Bus& bus, uint64_t* road, double* geo) const;
+
+	domain::BusStat ComputeBusStat(const domain::Bus& bus, domain::RouteDistances distances) const;
 };
 
 } // namespace transport_catalogue
@@ -6,12 +6,35 @@
 
 #include "transport_router.h"
 #include "transport_catalogue.h"
+#include "geo_grid.h"
 #include "graph.h"
+#include "path_search.h"
 #include "router.h"
 
 
 namespace transport_catalogue::transport_router {
 
+namespace {
+
+// грубая скорость релаксации при построении таблицы
+const double RELAXATIONS_PER_SECOND = 1e9;
+
+}  // namespace
+
+RouterTableEstimate EstimateRouterTable(size_t vertex_count, size_t edge_count) {
+	const size_t entry_size = graph::DispatchIndexWidth(graph::ChooseIndexWidth(edge_count), [](auto index) {
+		return sizeof(std::optional<typename graph::Router<Minutes, decltype(index)>::RouteInternalData>);
+	});
+
+	const double vertices = static_cast<double>(vertex_count);
+	RouterTableEstimate result;
+	result.memory = (vertices * vertices * entry_size
+			+ vertices * sizeof(std::vector<int>)) / (1024. * 1024.);
+	// инициализация проходит по рёбрам, релаксация — по всем тройкам вершин
+	result.build_time = (static_cast<double>(edge_count) + vertices * vertices * vertices) / RELAXATIONS_PER_SECOND;
+	return result;
+}
+
 void TransportRouter::SetRoutingSettings(RoutingSettings settings) {
 	settings_ = std::move(settings);
 }
@@ -22,7 +45,24 @@ const RoutingSettings& TransportRouter::GetRoutingSettings() const {
 
 void TransportRouter::BuildRouter(const TransportCatalogue& transport_catalogue) {
 	FillGraph(transport_catalogue);
-	router_ptr_ = std::make_unique<graph::Router<double>>(*graph_ptr_);
+	index_width_ = graph::ChooseIndexWidth(graph_ptr_->GetEdgeCount());
+
+	bool precompute_router = settings_.precompute_router;
+	engine_ = settings_.engine;
+	if (engine_ == RoutingEngine::AUTO) {
+		const auto estimate = EstimateRouterTable(graph_ptr_->GetVertexCount(), graph_ptr_->GetEdgeCount());
+		if (estimate.memory > settings_.table_memory_budget) {
+			engine_ = RoutingEngine::SEARCH;
+		} else {
+			// таблица помещается в память, но строится долго: её достроит process_requests в фоне
+			engine_ = RoutingEngine::TABLE;
+			precompute_router = precompute_router && estimate.build_time <= settings_.table_build_time_budget;
+		}
+	}
+	if (engine_ == RoutingEngine::SEARCH || !precompute_router) {
+		return;
+	}
+	router_ptr_ = std::make_unique<graph::RouterOfWidth<Minutes>>(*graph_ptr_, index_width_);
 	router_ptr_->Build();
 }
 
@@ -30,7 +70,19 @@ const graph::DirectedWeightedGraph<Minutes>& TransportRouter::GetGraph() const {
 	return *graph_ptr_;
 }
 
-const graph::Router<Minutes>& TransportRouter::GetRouter() const {
+RoutingEngine TransportRouter::GetEngine() const {
+	return engine_;
+}
+
+bool TransportRouter::HasRouter() const {
+	return router_ptr_ != nullptr;
+}
+
+graph::IndexWidth TransportRouter::GetIndexWidth() const {
+	return index_width_;
+}
+
+const graph::RouterOfWidth<Minutes>& TransportRouter::GetRouter() const {
 	return *router_ptr_;
 }
 
@@ -39,76 +91,137 @@ const EdgeInfo& TransportRouter::GetEdgeInfo(graph::EdgeId id) const {
 }
 
 std::optional<StopPairVertexId> TransportRouter::GetPairVertexId(domain::StopPtr stop) const {
-	if (!stop_ptr_to_pair_id_.count(stop)) {
+	if (stop->id >= stop_id_to_pair_id_.size()) {
 		return std::nullopt;
 	}
-	return stop_ptr_to_pair_id_.at(stop);
+	return stop_id_to_pair_id_[stop->id];
 }
 
 std::optional<RouteInfo> TransportRouter::GetRouteInfo(graph::VertexId from, graph::VertexId to) const {
+	if (!router_ptr_) {
+		const auto& route_info = graph::PathSearch<Minutes>(*graph_ptr_).BuildRoute(from, to);
+		if (!route_info) {
+			return std::nullopt;
+		}
+		return MakeRouteInfo(route_info->weight, route_info->edges);
+	}
+
 	const auto& route_info = router_ptr_->BuildRoute(from, to);
 	if (!route_info) {
 		return std::nullopt;
 	}
+	return MakeRouteInfo(route_info->weight, route_info->edges);
+}
+
+RouteInfo TransportRouter::MakeRouteInfo(Minutes total_time, const std::vector<graph::EdgeId>& edges) const {
 	RouteInfo result;
-	result.total_time = route_info->weight;
-	for (const auto edge : route_info->edges) {
+	result.total_time = total_time;
+	for (const auto edge : edges) {
 		result.edges.emplace_back(GetEdgeInfo(edge));
 	}
 	return result;
 }
 
-const std::unordered_map<domain::StopPtr, StopPairVertexId>&
-TransportRouter::GetStopToVertexIds() const {
-	return stop_ptr_to_pair_id_;
+const std::vector<StopPairVertexId>& TransportRouter::GetStopToVertexIds() const {
+	return stop_id_to_pair_id_;
 }
-const std::unordered_map<graph::EdgeId, EdgeInfo>&
-TransportRouter::GetEdgeIdToEdgeInfo() const {
+const std::vector<EdgeInfo>& TransportRouter::GetEdgeIdToEdgeInfo() const {
 	return edge_id_to_type_;
 }
 
+memory_usage::Report TransportRouter::MemoryUsage() const {
+	memory_usage::Report report;
+	if (graph_ptr_) {
+		report.Append("graph", graph_ptr_->MemoryUsage());
+	}
+	if (router_ptr_) {
+		report.Add(router_ptr_->MemoryUsage());
+	}
+	report.Add(memory_usage::OfVector("stop_id_to_pair_id", stop_id_to_pair_id_));
+	report.Add(memory_usage::OfVector("edge_id_to_type", edge_id_to_type_));
+	return report;
+}
+
 void TransportRouter::FillGraph(const TransportCatalogue& transport_catalogue) {
-	graph_ptr_ = std::make_unique<graph::DirectedWeightedGraph<Minutes>>(2 * transport_catalogue.GetStopPtrs().size());
-	FillStopIdDictionaries(transport_catalogue.GetStopPtrs());
-	AddWaitEdges();
+	const size_t stop_count = transport_catalogue.StopsAmount();
+	graph_ptr_ = std::make_unique<graph::DirectedWeightedGraph<Minutes>>(2 * stop_count);
+	FillStopIdDictionaries(stop_count);
+	AddWaitEdges(transport_catalogue);
 	AddBusEdges(transport_catalogue);
+	AddWalkEdges(transport_catalogue);
 }
 
-void TransportRouter::FillStopIdDictionaries(const std::deque<domain::StopPtr>& stops) {
-	size_t i = 0;
-	for (const auto stop : stops) {
-		graph::VertexId first_id = i++;
-		graph::VertexId second_id = i++;
-		stop_ptr_to_pair_id_[stop] = StopPairVertexId{first_id, second_id};
+void TransportRouter::FillStopIdDictionaries(size_t stop_count) {
+	stop_id_to_pair_id_.clear();
+	stop_id_to_pair_id_.reserve(stop_count);
+	for (graph::VertexId i = 0; i < 2 * stop_count; i += 2) {
+		stop_id_to_pair_id_.push_back(StopPairVertexId{i, i + 1});
 	}
 }
 
-void TransportRouter::AddWaitEdges() {
+graph::EdgeId TransportRouter::AddEdge(const graph::Edge<Minutes>& edge, EdgeInfo edge_info) {
+	const graph::EdgeId id = graph_ptr_->AddEdge(edge);
+	edge_id_to_type_.push_back(std::move(edge_info));
+	return id;
+}
+
+void TransportRouter::AddWaitEdges(const TransportCatalogue& transport_catalogue) {
 	using namespace graph;
-	for (const auto [stop_ptr, ids] : stop_ptr_to_pair_id_) {
-		graph::EdgeId id = graph_ptr_->AddEdge(Edge<Minutes>{
-			ids.bus_wait_begin, ids.bus_wait_end, settings_.bus_wait_time});
-		edge_id_to_type_[id] = WaitEdgeInfo{stop_ptr->name, settings_.bus_wait_time};
+	for (const auto& stop : transport_catalogue.GetStops()) {
+		const auto& ids = stop_id_to_pair_id_[stop.id];
+		AddEdge(Edge<Minutes>{ids.bus_wait_begin, ids.bus_wait_end, settings_.bus_wait_time},
+				WaitEdgeInfo{&stop, settings_.bus_wait_time});
 	}
 }
 
 void TransportRouter::AddBusEdges(const TransportCatalogue& transport_catalogue) {
 	using namespace graph;
 
-	for (const auto bus_ptr : transport_catalogue.GetBusPtrs()) {
-		ParseBusRouteOnEdges(bus_ptr->route.begin(), bus_ptr->route.end(), transport_catalogue, bus_ptr);
-		if (!bus_ptr->is_circle) {
-			ParseBusRouteOnEdges(bus_ptr->route.rbegin(), bus_ptr->route.rend(), transport_catalogue, bus_ptr);
+	for (const auto& bus : transport_catalogue.GetBuses()) {
+		const auto distances = transport_catalogue.GetRouteDistances(bus.id);
+		ParseBusRouteOnEdges(bus.route.begin(), bus.route.end(), distances, 0, &bus);
+		if (!bus.is_circle && !bus.route.empty()) {
+			// обратное направление начинается в пути маршрута с конечной остановки
+			ParseBusRouteOnEdges(bus.route.rbegin(), bus.route.rend(), distances, bus.route.size() - 1, &bus);
 		}
 	}
 }
 
+void TransportRouter::AddWalkEdges(const TransportCatalogue& transport_catalogue) {
+	if (settings_.walking_radius <= 0. || settings_.walking_velocity <= 0.) {
+		return;
+	}
+
+	const auto& stops = transport_catalogue.GetStops();
+	std::vector<geo::Coordinates> coordinates;
+	coordinates.reserve(stops.size());
+	for (const auto& stop : stops) {
+		coordinates.push_back(stop.coordinates);
+	}
+
+	// номера точек сетки совпадают с StopId
+	geo::Grid grid(coordinates, settings_.walking_radius);
+	grid.ForEachPairWithin(settings_.walking_radius,
+			[this, &stops](size_t lhs, size_t rhs, double distance) {
+				AddWalkEdge(&stops[lhs], &stops[rhs], distance);
+				AddWalkEdge(&stops[rhs], &stops[lhs], distance);
+			});
+}
+
+// пешеход приходит к началу ожидания автобуса на другой остановке
+void TransportRouter::AddWalkEdge(domain::StopPtr from, domain::StopPtr to, const double distance) {
+	using namespace graph;
+	const Minutes time = distance / (settings_.walking_velocity * 1000 / 60); // перевод скорости в м/мин
+	AddEdge(Edge<Minutes>{stop_id_to_pair_id_[from->id].bus_wait_begin, stop_id_to_pair_id_[to->id].bus_wait_begin, time},
+			WalkEdgeInfo{from, to, time});
+}
+
 graph::Edge<Minutes> TransportRouter::MakeBusEdge(domain::StopPtr from,
 		domain::StopPtr to, const double distance) const {
 	using namespace graph;
 	Edge<Minutes> result;
-	result.from = stop_ptr_to_pair_id_.at(from).bus_wait_end;
-	result.to = stop_ptr_to_pair_id_.at(to).bus_wait_begin;
+	result.from = stop_id_to_pair_id_[from->id].bus_wait_end;
+	result.to = stop_id_to_pair_id_[to->id].bus_wait_begin;
 	result.weight = distance * 1.0 / (settings_.bus_velocity * 1000 / 60); // перевод скорости в м/мин
 	return result;
 }
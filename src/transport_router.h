@@ -1,6 +1,7 @@
 #pragma once
 
 #include <deque>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -14,33 +15,63 @@
 #include "graph.h"
 #include "router.h"
 #include "domain.h"
+#include "memory_usage.h"
 
 namespace transport_catalogue::transport_router {
 
 using Minutes = double;
 
+// Способ ответа на запросы Route: таблица всех маршрутов graph::Router (память O(V^2))
+// или поиск на каждый запрос. AUTO выбирает способ на этапе make_base по размеру графа
+enum class RoutingEngine {
+	AUTO,
+	TABLE,
+	SEARCH,
+};
+
 struct RoutingSettings {
 	Minutes bus_wait_time = 0.; // мин
 	double bus_velocity = 0.; // км/ч
+	bool precompute_router = true; // строить ли таблицу маршрутов на этапе make_base
+	double walking_radius = 0.; // м, пешие переходы между остановками не дальше этого расстояния
+	double walking_velocity = 0.; // км/ч
+	RoutingEngine engine = RoutingEngine::TABLE;
+	double table_memory_budget = 1024.; // МБ, предел памяти таблицы маршрутов для AUTO
+	double table_build_time_budget = 60.; // с, предел времени построения таблицы для AUTO
+};
+
+// Оценка затрат на таблицу маршрутов graph::Router
+struct RouterTableEstimate {
+	double memory = 0.; // МБ
+	double build_time = 0.; // с
 };
 
+// таблица оценивается для ширины номеров рёбер ChooseIndexWidth(edge_count)
+RouterTableEstimate EstimateRouterTable(size_t vertex_count, size_t edge_count);
+
 struct StopPairVertexId {
 	graph::VertexId bus_wait_begin;
 	graph::VertexId bus_wait_end;
 };
 
 struct WaitEdgeInfo {
-	std::string_view stop_name;
+	domain::StopPtr stop = nullptr;
 	Minutes time = 0.;
 };
 
 struct BusEdgeInfo {
-	std::string_view bus_name;
+	domain::BusPtr bus = nullptr;
 	size_t span_count = 0;
 	Minutes time = 0.;
 };
 
-using EdgeInfo = std::variant<WaitEdgeInfo, BusEdgeInfo>;
+struct WalkEdgeInfo {
+	domain::StopPtr from = nullptr;
+	domain::StopPtr to = nullptr;
+	Minutes time = 0.;
+};
+
+using EdgeInfo = std::variant<WaitEdgeInfo, BusEdgeInfo, WalkEdgeInfo>;
 
 struct RouteInfo {
 	Minutes total_time = 0.;
@@ -56,7 +87,15 @@ public:
 
 	const graph::DirectedWeightedGraph<Minutes>& GetGraph() const;
 
-	const graph::Router<Minutes>& GetRouter() const;
+	// способ ответа на запросы, выбранный при BuildRouter (TABLE или SEARCH)
+	RoutingEngine GetEngine() const;
+
+	// ширина номеров рёбер таблицы маршрутов, выбранная по размеру графа при BuildRouter.
+	// Записывается в базу, даже если таблица строится уже в process_requests
+	graph::IndexWidth GetIndexWidth() const;
+
+	bool HasRouter() const;
+	const graph::RouterOfWidth<Minutes>& GetRouter() const;
 
 	const EdgeInfo& GetEdgeInfo(graph::EdgeId id) const;
 
@@ -64,53 +103,61 @@ public:
 
 	std::optional<RouteInfo> GetRouteInfo(graph::VertexId from, graph::VertexId to) const;
 
-	const std::unordered_map<domain::StopPtr, StopPairVertexId>& GetStopToVertexIds() const;
-	const std::unordered_map<graph::EdgeId, EdgeInfo>& GetEdgeIdToEdgeInfo() const;
-
+	// индекс — StopId
+	const std::vector<StopPairVertexId>& GetStopToVertexIds() const;
+	// индекс — EdgeId
+	const std::vector<EdgeInfo>& GetEdgeIdToEdgeInfo() const;
 
+	memory_usage::Report MemoryUsage() const;
 
 private:
 	RoutingSettings settings_;
+	RoutingEngine engine_ = RoutingEngine::TABLE;
+	graph::IndexWidth index_width_ = graph::IndexWidth::U64;
 	std::unique_ptr<graph::DirectedWeightedGraph<Minutes>> graph_ptr_;
-	std::unique_ptr<graph::Router<Minutes>> router_ptr_;
-	std::unordered_map<domain::StopPtr, StopPairVertexId> stop_ptr_to_pair_id_;
-	std::unordered_map<graph::EdgeId, EdgeInfo> edge_id_to_type_;
+	std::unique_ptr<graph::RouterOfWidth<Minutes>> router_ptr_;
+	std::vector<StopPairVertexId> stop_id_to_pair_id_;
+	std::vector<EdgeInfo> edge_id_to_type_;
 
 private:
 	void FillGraph(const TransportCatalogue& transport_catalogue);
 
-	void FillStopIdDictionaries(const std::deque<domain::StopPtr>& stops);
+	void FillStopIdDictionaries(size_t stop_count);
+
+	graph::EdgeId AddEdge(const graph::Edge<Minutes>& edge, EdgeInfo edge_info);
 
-	void AddWaitEdges();
+	void AddWaitEdges(const TransportCatalogue& transport_catalogue);
 
 	void AddBusEdges(const TransportCatalogue& transport_catalogue);
 
+	void AddWalkEdges(const TransportCatalogue& transport_catalogue);
+
+	void AddWalkEdge(domain::StopPtr from, domain::StopPtr to, const double distance);
+
+	// first_position — позиция остановки *first в пути маршрута
 	template <typename InputIt>
 	void ParseBusRouteOnEdges(InputIt first, InputIt last,
-			const TransportCatalogue& transport_catalogue, domain::BusPtr bus_ptr);
+			domain::RouteDistances distances, size_t first_position, domain::BusPtr bus_ptr);
 
 	graph::Edge<Minutes> MakeBusEdge(domain::StopPtr from, domain::StopPtr to, const double distance) const;
+
+	RouteInfo MakeRouteInfo(Minutes total_time, const std::vector<graph::EdgeId>& edges) const;
 };
 
 template <typename InputIt>
 void TransportRouter::ParseBusRouteOnEdges(InputIt first, InputIt last,
-		const TransportCatalogue& transport_catalogue, domain::BusPtr bus_ptr) {
+		domain::RouteDistances distances, size_t first_position, domain::BusPtr bus_ptr) {
 	for (auto iter = first; iter != last; ++iter) {
 		const auto from = *iter;
+		const size_t from_position = first_position + (iter - first);
 
-		{
-			size_t distance = 0;
-			size_t span_count = 0;
-
-			for (auto jter = next(iter); jter != last; ++jter) {
-				const auto before_to = *prev(jter);
-				const auto to = *jter;
-				distance += transport_catalogue.FindDistance(before_to, to);
-				++span_count;
+		size_t span_count = 0;
+		for (auto jter = std::next(iter); jter != last; ++jter) {
+			const auto to = *jter;
+			++span_count;
 
-				graph::EdgeId id = graph_ptr_->AddEdge(MakeBusEdge(from, to, distance));
-				edge_id_to_type_[id] = BusEdgeInfo{bus_ptr->name, span_count, graph_ptr_->GetEdge(id).weight};
-			}
+			const auto edge = MakeBusEdge(from, to, distances.GetRoadDistance(from_position, from_position + span_count));
+			AddEdge(edge, BusEdgeInfo{bus_ptr, span_count, edge.weight});
 		}
 	}
 }